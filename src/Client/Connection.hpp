@@ -32,24 +32,82 @@
 
 #include "RequestEncoder.hpp"
 #include "ResponseDecoder.hpp"
+#include "Schema.hpp"
+#include "Stats.hpp"
 
 #include "../Utils/rlist.h"
 #include "../Utils/Logger.hpp"
+#include "../Utils/LruCache.hpp"
+#include "../Utils/SyncTable.hpp"
+#include "../Utils/TimerWheel.hpp"
 #include "../Utils/Wrappers.hpp"
 
 #include <sys/uio.h>
 
 #include <any>
+#include <climits>
 #include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <set>
 
-/** Statistics concerning requests/responses. */
-struct ConnectionStat {
-	size_t send;
-	size_t read;
+
+/**
+ * Policy of handing encoded requests over to network provider. If all
+ * thresholds are disabled (default), each request is queued to be sent
+ * right away. Otherwise requests are held in output buffer and queued
+ * together once any of thresholds is reached, or once connector starts
+ * waiting for responses of the connection.
+ */
+struct FlushPolicy {
+	/** Flush when output buffer holds this many bytes; 0 - disabled. */
+	size_t bytes = 0;
+	/** Flush when this many requests are held; 0 - disabled. */
+	size_t requests = 0;
+	/**
+	 * Flush the next request encoded after the oldest held one
+	 * became older than this budget; 0 - disabled.
+	 */
+	std::chrono::microseconds delay{0};
+
+	bool isEnabled() const
+	{
+		return bytes != 0 || requests != 0 || delay.count() != 0;
+	}
+};
+
+/**
+ * Policy of restoring connection which has failed (disabled by default).
+ * Connector re-establishes such connection from its wait methods with
+ * exponential backoff. Requests which were sent (even partially) before
+ * the failure get a response with ER_NO_CONNECTION error. Requests which
+ * were not sent at all are replayed on the new connection if they are
+ * replayable (see ReplayMode and Connection::setReplayable()), otherwise
+ * they fail the same way.
+ */
+struct ReconnectPolicy {
+	enum ReplayMode {
+		/** Only requests marked by Connection::setReplayable(). */
+		REPLAY_MARKED,
+		/** Besides, all read-only requests (ping, select). */
+		REPLAY_IDEMPOTENT,
+		/** All requests which were not sent. */
+		REPLAY_ALL,
+	};
+	bool enabled = false;
+	ReplayMode replay = REPLAY_IDEMPOTENT;
+	/** Delay before the second attempt; the first one is immediate. */
+	std::chrono::milliseconds initial_delay{50};
+	/** The delay is doubled on each failed attempt up to this one. */
+	std::chrono::milliseconds max_delay{5000};
+	/** Give up after this many failed attempts in a row; 0 - never. */
+	size_t max_attempts = 0;
+
+	bool isEnabled() const { return enabled; }
 };
 
 /** rid == request id */
@@ -60,6 +118,10 @@ struct ConnectionStatus {
 	unsigned is_ready_to_decode : 1;
 	unsigned is_send_blocked : 1;
 	unsigned is_failed : 1;
+	/** Asynchronous connect or greeting is in progress. */
+	unsigned is_connecting : 1;
+	/** AUTH request is sent, but its response is not decoded yet. */
+	unsigned is_authenticating : 1;
 };
 
 struct ConnectionError {
@@ -74,6 +136,8 @@ template<class BUFFER, class NetProvider>
 class Connection {
 public:
 	using iterator = typename BUFFER::iterator;
+	/** Consumer of decoded response, see onResponse(). */
+	using ResponseHandler = std::function<void(Response<BUFFER> &)>;
 
 	/**
 	 * Public wrappers to access request methods in Tarantool way:
@@ -82,36 +146,67 @@ public:
 	 */
 	class Space {
 	public:
-		Space(Connection<BUFFER, NetProvider> &conn) :
-			index(conn, *this), m_Conn(conn) {};
+		Space(Connection<BUFFER, NetProvider> &conn,
+		      uint64_t stream_id = 0) :
+			index(conn, *this), m_Conn(conn),
+			m_StreamId(stream_id) {};
 		Space& operator[] (uint32_t id)
 		{
 			space_id = id;
 			return *this;
 		}
+		/**
+		 * Resolve space by name using schema fetched by
+		 * loadSchema(); unknown name resolves to Schema::NO_ID.
+		 */
+		Space& operator[] (std::string_view name)
+		{
+			space_id = m_Conn.m_Schema.findSpace(name)
+				   .value_or(Schema::NO_ID);
+			return *this;
+		}
 		template <class T>
 		rid_t insert(const T &tuple)
 		{
+			StreamScope scope(m_Conn, m_StreamId);
+			return m_Conn.insert(tuple, space_id);
+		}
+		template <class T>
+		rid_t insert(const T &tuple, ResponseHandler handler)
+		{
+			StreamScope scope(m_Conn, m_StreamId);
+			HandlerScope handled(m_Conn, handler);
 			return m_Conn.insert(tuple, space_id);
 		}
 		template <class T>
 		rid_t replace(const T &tuple)
 		{
+			StreamScope scope(m_Conn, m_StreamId);
+			return m_Conn.replace(tuple, space_id);
+		}
+		template <class T>
+		rid_t replace(const T &tuple, ResponseHandler handler)
+		{
+			StreamScope scope(m_Conn, m_StreamId);
+			HandlerScope handled(m_Conn, handler);
 			return m_Conn.replace(tuple, space_id);
 		}
 		template <class T>
 		rid_t delete_(const T &key, uint32_t index_id = 0)
 		{
+			StreamScope scope(m_Conn, m_StreamId);
 			return m_Conn.delete_(key, space_id, index_id);
 		}
 		template <class K, class T>
 		rid_t update(const K &key, const T &tuple, uint32_t index_id = 0)
 		{
+			StreamScope scope(m_Conn, m_StreamId);
 			return m_Conn.update(key, tuple, space_id, index_id);
 		}
 		template <class T, class O>
 		rid_t upsert(const T &tuple, const O &ops, uint32_t index_base = 0)
 		{
+			StreamScope scope(m_Conn, m_StreamId);
 			return m_Conn.upsert(tuple, ops, space_id, index_base);
 		}
 		template <class T>
@@ -119,9 +214,17 @@ public:
 			     uint32_t limit = UINT32_MAX,
 			     uint32_t offset = 0, IteratorType iterator = EQ)
 		{
+			StreamScope scope(m_Conn, m_StreamId);
 			return m_Conn.select(key, space_id, index_id, limit,
 					     offset, iterator);
 		}
+		template <class T>
+		rid_t select(const T& key, ResponseHandler handler)
+		{
+			StreamScope scope(m_Conn, m_StreamId);
+			HandlerScope handled(m_Conn, handler);
+			return m_Conn.select(key, space_id);
+		}
 		class Index {
 		public:
 			Index(Connection<BUFFER, NetProvider> &conn, Space &space) :
@@ -131,15 +234,24 @@ public:
 				index_id = id;
 				return *this;
 			}
+			Index& operator[] (std::string_view name)
+			{
+				const Schema &schema = m_Conn.m_Schema;
+				index_id = schema.findIndex(m_Space.space_id, name)
+					   .value_or(Schema::NO_ID);
+				return *this;
+			}
 			template <class T>
 			rid_t delete_(const T &key)
 			{
+				StreamScope scope(m_Conn, m_Space.m_StreamId);
 				return m_Conn.delete_(key, m_Space.space_id,
 						      index_id);
 			}
 			template <class K, class T>
 			rid_t update(const K &key, const T &tuple)
 			{
+				StreamScope scope(m_Conn, m_Space.m_StreamId);
 				return m_Conn.update(key, tuple,
 						     m_Space.space_id, index_id);
 			}
@@ -149,10 +261,19 @@ public:
 				     uint32_t offset = 0,
 				     IteratorType iterator = EQ)
 			{
+				StreamScope scope(m_Conn, m_Space.m_StreamId);
 				return m_Conn.select(key, m_Space.space_id,
 						     index_id, limit,
 						     offset, iterator);
 			}
+			template <class T>
+			rid_t select(const T &key, ResponseHandler handler)
+			{
+				StreamScope scope(m_Conn, m_Space.m_StreamId);
+				HandlerScope handled(m_Conn, handler);
+				return m_Conn.select(key, m_Space.space_id,
+						     index_id);
+			}
 		private:
 			Connection<BUFFER, NetProvider> &m_Conn;
 			Space &m_Space;
@@ -161,8 +282,67 @@ public:
 	private:
 		Connection<BUFFER, NetProvider> &m_Conn;
 		uint32_t space_id;
+		/** Requests go to this stream (0 - none). */
+		uint64_t m_StreamId;
 	} space;
 
+	/**
+	 * Stream of requests which server executes one by one in order of
+	 * their arrival; interactive transaction lives in a stream. Many
+	 * streams are multiplexed over the connection, so concurrent
+	 * transactions don't need connections of their own. Stream is
+	 * bound to the session: it's not restored by reconnect and its
+	 * requests are never replayed. Stream must not outlive connection.
+	 */
+	class Stream {
+	public:
+		Stream(Connection<BUFFER, NetProvider> &conn, uint64_t id) :
+			space(conn, id), m_Conn(conn), m_Id(id) {};
+		Stream(const Stream&) = delete;
+		Stream& operator = (const Stream&) = delete;
+		uint64_t getId() const { return m_Id; }
+		/** @a timeout is in seconds, 0 - server's default. */
+		rid_t begin(double timeout = 0,
+			    Iproto::TxnIsolation isolation =
+				Iproto::TXN_ISOLATION_DEFAULT)
+		{
+			StreamScope scope(m_Conn, m_Id);
+			return m_Conn.begin(timeout, isolation);
+		}
+		rid_t commit()
+		{
+			StreamScope scope(m_Conn, m_Id);
+			return m_Conn.commit();
+		}
+		rid_t rollback()
+		{
+			StreamScope scope(m_Conn, m_Id);
+			return m_Conn.rollback();
+		}
+		template <class T>
+		rid_t call(const std::string &func, const T &args)
+		{
+			StreamScope scope(m_Conn, m_Id);
+			return m_Conn.call(func, args);
+		}
+		template <class EXPR, class T>
+		rid_t eval(const EXPR &expr, const T &args)
+		{
+			StreamScope scope(m_Conn, m_Id);
+			return m_Conn.eval(expr, args);
+		}
+		template <class T>
+		rid_t execute(const std::string &statement, const T &parameters)
+		{
+			StreamScope scope(m_Conn, m_Id);
+			return m_Conn.execute(statement, parameters);
+		}
+		Space space;
+	private:
+		Connection<BUFFER, NetProvider> &m_Conn;
+		uint64_t m_Id;
+	};
+
 	Connection(Connector<BUFFER, NetProvider> &connector);
 	~Connection();
 	Connection(const Connection& connection) = delete;
@@ -170,15 +350,125 @@ public:
 
 	std::optional<Response<BUFFER>> getResponse(rid_t future);
 	bool futureIsReady(rid_t future);
+	/**
+	 * Pass response of @a future to @a handler right after it is
+	 * decoded instead of storing it: futureIsReady() and getResponse()
+	 * are not applicable to such future, but Connector::wait() still
+	 * is. If response is already decoded, handler is invoked at once;
+	 * if future is neither in flight nor decoded, handler is dropped.
+	 * Handler is called from Connector's wait methods, it may issue
+	 * new requests but must not wait on the connector itself.
+	 */
+	rid_t onResponse(rid_t future, ResponseHandler handler);
+	/** Forget handler of @a future: its response is going to be stored. */
+	void dropHandler(rid_t future);
 
 	template <class T>
 	rid_t call(const std::string &func, const T &args);
+	template <class T>
+	rid_t call(const std::string &func, const T &args,
+		   ResponseHandler handler);
 	rid_t ping();
+	rid_t ping(ResponseHandler handler);
+	/**
+	 * Evaluate Lua expression @a expr passing @a args to it. If @a expr
+	 * is known at compile time (e.g. "return ..."_cs), the constant part
+	 * of the request is encoded at compile time.
+	 */
+	template <class EXPR, class T>
+	rid_t eval(const EXPR &expr, const T &args);
+	template <class EXPR, class T>
+	rid_t eval(const EXPR &expr, const T &args, ResponseHandler handler);
+	/** Execute SQL @a statement with @a parameters bound to it. */
+	template <class T>
+	rid_t execute(const std::string &statement, const T &parameters);
+	template <class T>
+	rid_t execute(const std::string &statement, const T &parameters,
+		      ResponseHandler handler);
+	/** Execute statement prepared by prepare() in this session. */
+	template <class T>
+	rid_t execute(uint32_t stmt_id, const T &parameters);
+	/**
+	 * Prepare SQL @a statement: its id (and metadata) come in
+	 * response.body. Prepared statements belong to the session, so
+	 * they are lost with reconnect.
+	 */
+	rid_t prepare(const std::string &statement);
+	rid_t unprepare(uint32_t stmt_id);
+	/**
+	 * Execute SQL @a statement using statement cache of the connection.
+	 * The first execution sends PREPARE along with EXECUTE of the text
+	 * (so it costs no extra round trip); once the statement is
+	 * prepared, only its id and @a parameters are sent. The least
+	 * recently used statements are unprepared on cache overflow.
+	 */
+	template <class T>
+	rid_t executeCached(const std::string &statement, const T &parameters);
+	/** Capacity of statement cache; 0 disables caching. */
+	void setStatementCacheSize(size_t size);
+	/**
+	 * Fetch names of spaces and indexes (_vspace and _vindex) so that
+	 * space["name"].index["name"] resolve them locally. Whenever any
+	 * response reports another schema version, the names are re-fetched
+	 * in background; requests are not bound to the version, so they are
+	 * not rejected by the server meanwhile. Return the future which
+	 * completes the fetch.
+	 */
+	rid_t loadSchema();
+	const Schema& getSchema() const { return m_Schema; }
+	/** Open new stream, ids are unique within the connection. */
+	Stream openStream() { return Stream(*this, ++m_LastStreamId); }
 
 	void setError(const std::string &msg);
 	std::string& getError();
 	void reset();
 
+	/** Hold encoded requests until uncork() or flush() is called. */
+	void cork();
+	/** Stop holding requests and queue held ones to be sent. */
+	void uncork();
+	/** Send all encoded requests (even if connection is corked) now. */
+	void flush();
+	void setFlushPolicy(const FlushPolicy &policy);
+	const ConnectionStat& getStat() const;
+	/**
+	 * Latency histogram of requests of given type (see ConnectionStats
+	 * for details). nullptr if there were no such requests yet or
+	 * statistics are disabled.
+	 */
+	const LatencyHistogram *getLatency(uint32_t type) const;
+	/**
+	 * Policy must be set before sending requests: only requests
+	 * encoded under enabled policy are tracked to be replayed.
+	 */
+	void setReconnectPolicy(const ReconnectPolicy &policy);
+	/** Replay request @a future after reconnect if it is not sent. */
+	void setReplayable(rid_t future);
+	/** Connection is failed and connector is going to restore it. */
+	bool isReconnecting() { return ! rlist_empty(&m_in_reconnect); }
+	/** Count of encoded requests whose responses are not decoded yet. */
+	size_t getInFlight() const { return m_Pending.size() + m_HandledOnly; }
+	/** Count of decoded responses which are not taken yet. */
+	size_t getReadyCount() const { return m_Futures.size(); }
+	/**
+	 * Complete @a future with ER_TIMEOUT error unless its response is
+	 * decoded by @a deadline; the response is dropped once it comes.
+	 * Deadlines are checked by Connector's wait methods. Deadline of
+	 * request which is not in flight anymore is ignored.
+	 */
+	void setDeadline(rid_t future,
+			 std::chrono::steady_clock::time_point deadline);
+	/** Set deadline of each request encoded from now on (0 - none). */
+	void setRequestTimeout(std::chrono::milliseconds timeout);
+	/**
+	 * Authenticate (chap-sha1) as @a user on each connect and
+	 * reconnect. AUTH request is sent right after the greeting in front
+	 * of requests queued meanwhile, so connect doesn't wait for extra
+	 * round trip. Credentials must be set before connecting. Rejected
+	 * AUTH fails the connection, such connection is not restored.
+	 */
+	void setCredentials(const std::string &user, const std::string &passwd);
+
 	BUFFER& getInBuf();
 
 #ifndef NDEBUG
@@ -201,6 +491,15 @@ public:
 	friend
 	void hasNotRecvBytes(Connection<B, N> &conn, size_t bytes);
 
+	template<class B, class N>
+	friend
+	void statSendCall(Connection<B, N> &conn, const struct iovec *iov,
+			  size_t iov_cnt, ssize_t rc);
+
+	template<class B, class N>
+	friend
+	void statRecvCall(Connection<B, N> &conn, ssize_t rc);
+
 	template<class B, class N>
 	friend
 	bool hasDataToSend(Connection<B, N> &conn);
@@ -217,15 +516,32 @@ public:
 	friend
 	int decodeGreeting(Connection<B, N> &conn);
 
+	template<class B, class N>
+	friend
+	size_t greetingBytesLeft(Connection<B, N> &conn);
+
 	int socket;
 	ConnectionStatus status;
 	/** Link Connector::m_ready_to_read */
 	struct rlist m_in_read;
 	/** Link NetworkProvider::m_ready_to_write */
 	struct rlist m_in_write;
+	/** Link Connector::m_held */
+	struct rlist m_in_hold;
 	void readyToDecode();
+	/**
+	 * Initial size of iovec array. It is doubled (up to MAX_IOVEC_COUNT)
+	 * each time encoded requests (or receive reservation) do not fit
+	 * into it, so deep pipelines are sent with fewer syscalls.
+	 */
 	static constexpr size_t AVAILABLE_IOVEC_COUNT = 32;
+#ifdef IOV_MAX
+	static constexpr size_t MAX_IOVEC_COUNT = IOV_MAX;
+#else
+	static constexpr size_t MAX_IOVEC_COUNT = 1024;
+#endif
 	static constexpr size_t GC_STEP_CNT = 5;
+	static constexpr size_t STATEMENT_CACHE_SIZE = 64;
 private:
 	Connector<BUFFER, NetProvider> &m_Connector;
 
@@ -239,11 +555,167 @@ private:
 	 * of already encoded requests).
 	 */
 	iterator m_EndEncoded;
-	struct iovec m_IOVecs[AVAILABLE_IOVEC_COUNT];
+	std::vector<struct iovec> m_IOVecs;
 	ConnectionError m_Error;
 	Greeting m_Greeting;
 
-	std::unordered_map<rid_t, Response<BUFFER>> m_Futures;
+	/** Decoded responses indexed by their syncs. */
+	tnt::SyncTable<Response<BUFFER>> m_Futures;
+	/**
+	 * Handler of response which is not stored in m_Futures. Request
+	 * made with handler is not kept in m_Pending unless it may expire
+	 * or be replayed: stamp of such request is here.
+	 */
+	struct HandledRequest : RequestStamp_t {
+		explicit HandledRequest(ResponseHandler &&h) :
+			handler(std::move(h)) {}
+		ResponseHandler handler;
+	};
+	tnt::SyncTable<HandledRequest> m_Handlers;
+	/** Count of requests in flight which are in m_Handlers only. */
+	size_t m_HandledOnly;
+	/** Handler of request being encoded, see HandlerScope. */
+	ResponseHandler *m_EncodedHandler;
+	/** Count of decoded responses to flush input buffer periodically. */
+	size_t m_GCStep;
+
+	ConnectionStats_t m_Stats;
+	FlushPolicy m_FlushPolicy;
+	bool m_IsCorked;
+	/** Count of encoded requests which are not queued to be sent. */
+	size_t m_HeldRequests;
+	/** Time when the oldest of held requests was encoded. */
+	std::chrono::steady_clock::time_point m_HeldSince;
+	/** Count of bytes sent (or dropped) from output buffer so far. */
+	uint64_t m_SentBytes;
+
+	/** Request which is not answered yet, tracked in reconnect mode. */
+	struct UnansweredRequest {
+		rid_t sync;
+		/** End of the request in the stream of all encoded bytes. */
+		uint64_t end;
+		uint32_t size;
+		uint32_t type;
+		bool is_replayable;
+		bool is_answered;
+		/** Stream requests make sense only in their session. */
+		bool is_in_stream;
+	};
+	ReconnectPolicy m_ReconnectPolicy;
+	/** Ordered by sync; answered ones are popped from the front. */
+	std::deque<UnansweredRequest> m_Unanswered;
+	/** Link Connector::m_reconnecting */
+	struct rlist m_in_reconnect;
+	/** Address the connection is restored to. */
+	std::string m_Address;
+	unsigned m_Port;
+	size_t m_ConnectTimeout;
+	size_t m_ReconnectAttempts;
+	std::chrono::milliseconds m_ReconnectDelay;
+	std::chrono::steady_clock::time_point m_ReconnectAt;
+
+	/**
+	 * Request whose response is not decoded yet. Its timer is linked to
+	 * Connector::m_DeadlineWheel if the request has a deadline. Stamp is
+	 * used for latency statistics (empty if they are disabled).
+	 */
+	struct PendingRequest : tnt::WheelTimer<PendingRequest>, RequestStamp_t {
+		PendingRequest(Connection *c, rid_t s) : conn(c), sync(s) {}
+		Connection *conn;
+		rid_t sync;
+	};
+	/**
+	 * Requests in flight indexed by their syncs. Response to a request
+	 * which is not here (e.g. expired one) is dropped as it comes.
+	 */
+	tnt::SyncTable<PendingRequest> m_Pending;
+	std::chrono::milliseconds m_RequestTimeout;
+	std::string m_User;
+	std::string m_Password;
+	/** Sync of AUTH request, valid while status.is_authenticating. */
+	rid_t m_AuthSync;
+
+	/** Entry of statement cache, see executeCached(). */
+	struct CachedStatement {
+		/** Sync of PREPARE request, valid until it's answered. */
+		rid_t prepare_sync;
+		uint32_t stmt_id;
+		bool is_prepared;
+	};
+	/** SQL text -> id of statement prepared in current session. */
+	tnt::LruCache<std::string, CachedStatement> m_Statements;
+	uint64_t m_LastStreamId;
+	/** Names of spaces and indexes, see loadSchema(). */
+	Schema m_Schema;
+	/** Schema being fetched. */
+	Schema m_NewSchema;
+	/** Count of unanswered schema requests (0 - not fetching). */
+	size_t m_SchemaRequests;
+	/** Future of the last schema request. */
+	rid_t m_SchemaFuture;
+	bool m_IsSchemaFailed;
+	/** Versions reported by responses of _vspace and _vindex. */
+	int m_NewSchemaVersions[2];
+
+	/** Stamp stream id into requests encoded within the scope. */
+	class StreamScope {
+	public:
+		StreamScope(Connection<BUFFER, NetProvider> &conn,
+			    uint64_t stream_id) : m_Encoder(conn.m_Encoder)
+		{
+			m_Encoder.setStreamId(stream_id);
+		}
+		~StreamScope() { m_Encoder.setStreamId(0); }
+	private:
+		RequestEncoder<BUFFER> &m_Encoder;
+	};
+
+	/** Pass response of request encoded within the scope to handler. */
+	class HandlerScope {
+	public:
+		HandlerScope(Connection<BUFFER, NetProvider> &conn,
+			     ResponseHandler &handler) : m_Conn(conn)
+		{
+			m_Conn.m_EncodedHandler = &handler;
+		}
+		~HandlerScope() { m_Conn.m_EncodedHandler = nullptr; }
+	private:
+		Connection<BUFFER, NetProvider> &m_Conn;
+	};
+
+	void requestEncoded(uint32_t type);
+	/** Keep request tracked by its handler only in m_Pending too. */
+	PendingRequest *trackPending(rid_t future);
+	UnansweredRequest *findUnanswered(rid_t sync);
+	void requestAnswered(rid_t sync);
+	/**
+	 * Forget the state of the lost socket: drop partially received
+	 * response, fail sent requests and keep unsent replayable ones in
+	 * output buffer (unless @a can_replay is false).
+	 */
+	void failLostRequests(bool can_replay);
+	/** Drop received bytes which are not decoded yet. */
+	void dropUndecoded();
+	void deliverResponse(Response<BUFFER> &response);
+	/** Complete @a sync with error response made up by connector. */
+	void deliverError(rid_t sync, uint32_t errcode, const char *msg);
+	/** Invoked by Connector when deadline of @a sync has come. */
+	void requestExpired(rid_t sync);
+	/** Put AUTH request in front of queued ones. */
+	void authenticate();
+	void authAnswered(Response<BUFFER> &response);
+	void statementPrepared(const std::string &statement, rid_t sync,
+			       Response<BUFFER> &response);
+	void statementEvicted(CachedStatement &victim);
+	/** Send selects of _vspace and _vindex. */
+	rid_t fetchSchema();
+	void schemaFetched(Response<BUFFER> &response, bool is_index);
+	/** Unprepare statement dropping response of the request. */
+	void dropStatement(uint32_t stmt_id);
+	void releaseHeld(size_t ConnectionStat::*reason);
+	bool growIOV();
+
+	friend class Connector<BUFFER, NetProvider>;
 
 	template <class T>
 	rid_t insert(const T &tuple, uint32_t space_id);
@@ -262,6 +734,10 @@ private:
 		     uint32_t space_id, uint32_t index_id = 0,
 		     uint32_t limit = UINT32_MAX,
 		     uint32_t offset = 0, IteratorType iterator = EQ);
+	/* Transaction control makes sense only within a Stream. */
+	rid_t begin(double timeout, Iproto::TxnIsolation isolation);
+	rid_t commit();
+	rid_t rollback();
 };
 
 template<class BUFFER, class NetProvider>
@@ -270,12 +746,24 @@ Connection<BUFFER, NetProvider>::Connection(Connector<BUFFER, NetProvider> &conn
 				   m_Connector(connector), m_InBuf(), m_OutBuf(),
 				   m_Encoder(m_OutBuf), m_Decoder(m_InBuf),
 				   m_EndDecoded(m_InBuf.begin()),
-				   m_EndEncoded(m_OutBuf.begin())
+				   m_EndEncoded(m_OutBuf.begin()),
+				   m_IOVecs(AVAILABLE_IOVEC_COUNT), m_HandledOnly(0),
+				   m_EncodedHandler(nullptr), m_GCStep(0),
+				   m_Stats(&connector.m_Stats), m_FlushPolicy(), m_IsCorked(false),
+				   m_HeldRequests(0), m_SentBytes(0), m_Port(0),
+				   m_ConnectTimeout(0), m_ReconnectAttempts(0),
+				   m_RequestTimeout(0), m_AuthSync(0),
+				   m_Statements(STATEMENT_CACHE_SIZE),
+				   m_LastStreamId(0), m_SchemaRequests(0),
+				   m_SchemaFuture(0), m_IsSchemaFailed(false),
+				   m_NewSchemaVersions()
 {
 	LOG_DEBUG("Creating connection...");
 	memset(&status, 0, sizeof(status));
 	rlist_create(&m_in_write);
 	rlist_create(&m_in_read);
+	rlist_create(&m_in_hold);
+	rlist_create(&m_in_reconnect);
 }
 
 template<class BUFFER, class NetProvider>
@@ -293,25 +781,50 @@ Connection<BUFFER, NetProvider>::~Connection()
 		rlist_del(&m_in_read);
 		LOG_WARNING("Connection ", this, " had unread data in input buffer!");
 	}
+	if (! rlist_empty(&m_in_hold)) {
+		rlist_del(&m_in_hold);
+		LOG_WARNING("Connection ", this, " had held requests!");
+	}
+	if (! rlist_empty(&m_in_reconnect))
+		rlist_del(&m_in_reconnect);
 }
 
 template<class BUFFER, class NetProvider>
 std::optional<Response<BUFFER>>
 Connection<BUFFER, NetProvider>::getResponse(rid_t future)
 {
-	auto entry = m_Futures.find(future);
-	if (entry == m_Futures.end())
-		return std::nullopt;
-	Response<BUFFER> response = std::move(entry->second);
-	m_Futures.erase(future);
-	return std::make_optional(std::move(response));
+	return m_Futures.take(future);
 }
 
 template<class BUFFER, class NetProvider>
 bool
 Connection<BUFFER, NetProvider>::futureIsReady(rid_t future)
 {
-	return m_Futures.find(future) != m_Futures.end();
+	return m_Futures.find(future) != nullptr;
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::onResponse(rid_t future,
+					    ResponseHandler handler)
+{
+	if (m_Pending.find(future) != nullptr) {
+		m_Handlers.emplace(future, std::move(handler));
+		return future;
+	}
+	std::optional<Response<BUFFER>> response = m_Futures.take(future);
+	if (response.has_value())
+		handler(*response);
+	return future;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::dropHandler(rid_t future)
+{
+	if (m_HandledOnly != 0 && m_Pending.find(future) == nullptr)
+		trackPending(future);
+	m_Handlers.erase(future);
 }
 
 template<class BUFFER, class NetProvider>
@@ -327,8 +840,18 @@ rid_t
 Connection<BUFFER, NetProvider>::call(const std::string &func, const T &args)
 {
 	m_EndEncoded += m_Encoder.encodeCall(func, args);
-	m_Connector.readyToSend(*this);
-	return RequestEncoder<BUFFER>::getSync();
+	requestEncoded(Iproto::CALL);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+template <class T>
+rid_t
+Connection<BUFFER, NetProvider>::call(const std::string &func, const T &args,
+				      ResponseHandler handler)
+{
+	HandlerScope handled(*this, handler);
+	return call(func, args);
 }
 
 template<class BUFFER, class NetProvider>
@@ -336,8 +859,162 @@ rid_t
 Connection<BUFFER, NetProvider>::ping()
 {
 	m_EndEncoded += m_Encoder.encodePing();
-	m_Connector.readyToSend(*this);
-	return RequestEncoder<BUFFER>::getSync();
+	requestEncoded(Iproto::PING);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::ping(ResponseHandler handler)
+{
+	HandlerScope handled(*this, handler);
+	return ping();
+}
+
+template<class BUFFER, class NetProvider>
+template <class EXPR, class T>
+rid_t
+Connection<BUFFER, NetProvider>::eval(const EXPR &expr, const T &args)
+{
+	m_EndEncoded += m_Encoder.encodeEval(expr, args);
+	requestEncoded(Iproto::EVAL);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+template <class EXPR, class T>
+rid_t
+Connection<BUFFER, NetProvider>::eval(const EXPR &expr, const T &args,
+				      ResponseHandler handler)
+{
+	HandlerScope handled(*this, handler);
+	return eval(expr, args);
+}
+
+template<class BUFFER, class NetProvider>
+template <class T>
+rid_t
+Connection<BUFFER, NetProvider>::execute(const std::string &statement,
+					 const T &parameters)
+{
+	m_EndEncoded += m_Encoder.encodeExecute(statement, parameters);
+	requestEncoded(Iproto::EXECUTE);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+template <class T>
+rid_t
+Connection<BUFFER, NetProvider>::execute(const std::string &statement,
+					 const T &parameters,
+					 ResponseHandler handler)
+{
+	HandlerScope handled(*this, handler);
+	return execute(statement, parameters);
+}
+
+template<class BUFFER, class NetProvider>
+template <class T>
+rid_t
+Connection<BUFFER, NetProvider>::execute(uint32_t stmt_id, const T &parameters)
+{
+	m_EndEncoded += m_Encoder.encodeExecute(stmt_id, parameters);
+	requestEncoded(Iproto::EXECUTE);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::prepare(const std::string &statement)
+{
+	m_EndEncoded += m_Encoder.encodePrepare(statement);
+	requestEncoded(Iproto::PREPARE);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::unprepare(uint32_t stmt_id)
+{
+	m_EndEncoded += m_Encoder.encodeUnprepare(stmt_id);
+	requestEncoded(Iproto::PREPARE);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+template <class T>
+rid_t
+Connection<BUFFER, NetProvider>::executeCached(const std::string &statement,
+					       const T &parameters)
+{
+	if (m_Statements.capacity() == 0)
+		return execute(statement, parameters);
+	CachedStatement *cached = m_Statements.find(statement);
+	if (cached != nullptr && cached->is_prepared)
+		return execute(cached->stmt_id, parameters);
+	if (cached == nullptr) {
+		rid_t sync = prepare(statement);
+		m_Statements.insert(statement, {sync, 0, false},
+				    [this](const std::string &,
+					   CachedStatement &victim) {
+			statementEvicted(victim);
+		});
+		onResponse(sync, [this, statement, sync](Response<BUFFER> &r) {
+			statementPrepared(statement, sync, r);
+		});
+	}
+	/* Statement is being prepared: the text is sent meanwhile. */
+	return execute(statement, parameters);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::setStatementCacheSize(size_t size)
+{
+	m_Statements.setCapacity(size, [this](const std::string &,
+					      CachedStatement &victim) {
+		statementEvicted(victim);
+	});
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::statementPrepared(const std::string &statement,
+						   rid_t sync,
+						   Response<BUFFER> &response)
+{
+	CachedStatement *cached = m_Statements.peek(statement);
+	bool is_awaited = cached != nullptr && ! cached->is_prepared &&
+			  cached->prepare_sync == sync;
+	if (response.body.stmt_id == std::nullopt) {
+		/* Failed: the statement will be sent as text next time. */
+		if (is_awaited)
+			m_Statements.erase(statement);
+		return;
+	}
+	if (! is_awaited) {
+		/* Evicted from the cache while being prepared. */
+		dropStatement(*response.body.stmt_id);
+		return;
+	}
+	cached->stmt_id = *response.body.stmt_id;
+	cached->is_prepared = true;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::statementEvicted(CachedStatement &victim)
+{
+	/* Statement being prepared is dropped by statementPrepared(). */
+	if (victim.is_prepared)
+		dropStatement(victim.stmt_id);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::dropStatement(uint32_t stmt_id)
+{
+	onResponse(unprepare(stmt_id), [](Response<BUFFER> &) {});
 }
 
 template<class BUFFER, class NetProvider>
@@ -346,8 +1023,8 @@ rid_t
 Connection<BUFFER, NetProvider>::insert(const T &tuple, uint32_t space_id)
 {
 	m_EndEncoded += m_Encoder.encodeInsert(tuple, space_id);
-	m_Connector.readyToSend(*this);
-	return RequestEncoder<BUFFER>::getSync();
+	requestEncoded(Iproto::INSERT);
+	return m_Encoder.getSync();
 }
 
 template<class BUFFER, class NetProvider>
@@ -356,8 +1033,8 @@ rid_t
 Connection<BUFFER, NetProvider>::replace(const T &tuple, uint32_t space_id)
 {
 	m_EndEncoded += m_Encoder.encodeReplace(tuple, space_id);
-	m_Connector.readyToSend(*this);
-	return RequestEncoder<BUFFER>::getSync();
+	requestEncoded(Iproto::REPLACE);
+	return m_Encoder.getSync();
 }
 
 template<class BUFFER, class NetProvider>
@@ -367,8 +1044,8 @@ Connection<BUFFER, NetProvider>::delete_(const T &key, uint32_t space_id,
 					 uint32_t index_id)
 {
 	m_EndEncoded += m_Encoder.encodeDelete(key, space_id, index_id);
-	m_Connector.readyToSend(*this);
-	return RequestEncoder<BUFFER>::getSync();
+	requestEncoded(Iproto::DELETE);
+	return m_Encoder.getSync();
 }
 
 template<class BUFFER, class NetProvider>
@@ -378,8 +1055,8 @@ Connection<BUFFER, NetProvider>::update(const K &key, const T &tuple,
 					uint32_t space_id, uint32_t index_id)
 {
 	m_EndEncoded += m_Encoder.encodeUpdate(key, tuple, space_id, index_id);
-	m_Connector.readyToSend(*this);
-	return RequestEncoder<BUFFER>::getSync();
+	requestEncoded(Iproto::UPDATE);
+	return m_Encoder.getSync();
 }
 
 template<class BUFFER, class NetProvider>
@@ -389,8 +1066,8 @@ Connection<BUFFER, NetProvider>::upsert(const T &tuple, const O &ops,
 					uint32_t space_id, uint32_t index_base)
 {
 	m_EndEncoded += m_Encoder.encodeUpsert(tuple, ops, space_id, index_base);
-	m_Connector.readyToSend(*this);
-	return RequestEncoder<BUFFER>::getSync();
+	requestEncoded(Iproto::UPSERT);
+	return m_Encoder.getSync();
 }
 
 template<class BUFFER, class NetProvider>
@@ -402,8 +1079,96 @@ Connection<BUFFER, NetProvider>::select(const T &key, uint32_t space_id,
 {
 	m_EndEncoded += m_Encoder.encodeSelect(key, space_id, index_id, limit,
 					       offset, iterator);
-	m_Connector.readyToSend(*this);
-	return RequestEncoder<BUFFER>::getSync();
+	requestEncoded(Iproto::SELECT);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::loadSchema()
+{
+	if (m_SchemaRequests != 0)
+		return m_SchemaFuture;
+	return fetchSchema();
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::fetchSchema()
+{
+	m_NewSchema.clear();
+	m_IsSchemaFailed = false;
+	m_SchemaRequests = 2;
+	rid_t spaces = select(std::make_tuple(), Schema::VSPACE_ID, 0,
+			      UINT32_MAX, 0, ALL);
+	rid_t indexes = select(std::make_tuple(), Schema::VINDEX_ID, 0,
+			       UINT32_MAX, 0, ALL);
+	onResponse(spaces, [this](Response<BUFFER> &response) {
+		schemaFetched(response, false);
+	});
+	onResponse(indexes, [this](Response<BUFFER> &response) {
+		schemaFetched(response, true);
+	});
+	m_SchemaFuture = indexes;
+	return indexes;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::schemaFetched(Response<BUFFER> &response,
+					       bool is_index)
+{
+	if (response.body.error_stack != std::nullopt ||
+	    response.body.data == std::nullopt ||
+	    ! m_NewSchema.decode(m_InBuf, *response.body.data, is_index))
+		m_IsSchemaFailed = true;
+	m_NewSchemaVersions[is_index] = response.header.schema_id;
+	if (--m_SchemaRequests != 0)
+		return;
+	if (m_IsSchemaFailed) {
+		/* The outdated schema (if any) is kept. */
+		LOG_ERROR("Failed to fetch schema");
+		m_NewSchema.clear();
+		return;
+	}
+	if (m_NewSchemaVersions[0] != m_NewSchemaVersions[1]) {
+		/* Schema has changed between the two selects. */
+		fetchSchema();
+		return;
+	}
+	m_NewSchema.build(m_NewSchemaVersions[0]);
+	std::swap(m_Schema, m_NewSchema);
+	m_NewSchema.clear();
+	LOG_DEBUG("Fetched schema version ", m_Schema.getVersion(), ", ",
+		  m_Schema.spaceCount(), " spaces");
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::begin(double timeout,
+				       Iproto::TxnIsolation isolation)
+{
+	m_EndEncoded += m_Encoder.encodeBegin(timeout, isolation);
+	requestEncoded(Iproto::TXN_BEGIN);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::commit()
+{
+	m_EndEncoded += m_Encoder.encodeCommit();
+	requestEncoded(Iproto::TXN_COMMIT);
+	return m_Encoder.getSync();
+}
+
+template<class BUFFER, class NetProvider>
+rid_t
+Connection<BUFFER, NetProvider>::rollback()
+{
+	m_EndEncoded += m_Encoder.encodeRollback();
+	requestEncoded(Iproto::TXN_ROLLBACK);
+	return m_Encoder.getSync();
 }
 
 template<class BUFFER, class NetProvider>
@@ -412,6 +1177,13 @@ Connection<BUFFER, NetProvider>::setError(const std::string &msg)
 {
 	m_Error.msg = msg;
 	status.is_failed = true;
+	if (isReconnecting())
+		return;
+	/* Connection which was established once is restored. */
+	if (m_ReconnectPolicy.isEnabled() && ! m_Address.empty())
+		m_Connector.connectionLost(*this);
+	else
+		m_Connector.connectionFailed(*this);
 }
 
 template<class BUFFER, class NetProvider>
@@ -425,6 +1197,9 @@ template<class BUFFER, class NetProvider>
 void
 Connection<BUFFER, NetProvider>::reset()
 {
+	/* Requests of failed connection are never going to be answered. */
+	if (status.is_failed && ! isReconnecting())
+		failLostRequests(false);
 	std::memset(&status, 0, sizeof(status));
 }
 
@@ -435,6 +1210,420 @@ Connection<BUFFER, NetProvider>::getInBuf()
 	return m_InBuf;
 }
 
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::cork()
+{
+	m_IsCorked = true;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::uncork()
+{
+	m_IsCorked = false;
+	releaseHeld(&ConnectionStat::flush_explicit);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::flush()
+{
+	releaseHeld(&ConnectionStat::flush_explicit);
+	m_Connector.flush(*this);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::setFlushPolicy(const FlushPolicy &policy)
+{
+	m_FlushPolicy = policy;
+	if (! m_IsCorked && ! m_FlushPolicy.isEnabled())
+		releaseHeld(&ConnectionStat::flush_explicit);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::deliverResponse(Response<BUFFER> &response)
+{
+	std::optional<HandledRequest> handled = std::nullopt;
+	if (m_Handlers.size() != 0)
+		handled = m_Handlers.take(response.header.sync);
+	if (handled.has_value())
+		handled->handler(response);
+	else
+		m_Futures.insert(response.header.sync, std::move(response));
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::deliverError(rid_t sync, uint32_t errcode,
+					      const char *msg)
+{
+	Response<BUFFER> response{};
+	response.header.code = Iproto::TYPE_ERROR | errcode;
+	response.header.sync = sync;
+	response.size = 0;
+	ErrorStack stack{};
+	stack.count = 1;
+	stack.error.errcode = errcode;
+	stack.error.msg_len = std::min(strlen(msg), sizeof(stack.error.msg) - 1);
+	memcpy(stack.error.msg, msg, stack.error.msg_len);
+	response.body.error_stack = stack;
+	m_Pending.erase(sync);
+	deliverResponse(response);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::setDeadline(rid_t future,
+		std::chrono::steady_clock::time_point deadline)
+{
+	PendingRequest *request = m_Pending.find(future);
+	if (request == nullptr && m_HandledOnly != 0)
+		request = trackPending(future);
+	if (request != nullptr)
+		m_Connector.addDeadline(*request, deadline);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::setRequestTimeout(std::chrono::milliseconds timeout)
+{
+	m_RequestTimeout = timeout;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::setCredentials(const std::string &user,
+						const std::string &passwd)
+{
+	m_User = user;
+	m_Password = passwd;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::authenticate()
+{
+	/*
+	 * Nothing is sent before the greeting, so the whole output buffer
+	 * is requests queued during connect (or ones to be replayed).
+	 */
+	size_t queued = m_EndEncoded - m_OutBuf.begin();
+	std::string pending(queued, '\0');
+	if (queued != 0) {
+		iterator itr = m_OutBuf.begin();
+		m_OutBuf.get(itr, &pending[0], queued);
+		m_OutBuf.dropFront(queued);
+	}
+	size_t auth_size = m_Encoder.encodeAuth(m_User, m_Password,
+						 m_Greeting.salt);
+	m_EndEncoded += auth_size;
+	m_AuthSync = m_Encoder.getSync();
+	status.is_authenticating = true;
+	if (queued != 0) {
+		m_OutBuf.addBack(wrap::Data{pending.data(), queued});
+		m_EndEncoded += queued;
+	}
+	/* Requests tracked for replay are shifted in the stream. */
+	for (UnansweredRequest &r : m_Unanswered)
+		r.end += auth_size;
+	/* Held requests go along with AUTH, they are in the same buffer. */
+	if (m_HeldRequests != 0)
+		releaseHeld(&ConnectionStat::flush_explicit);
+	else
+		m_Connector.readyToSend(*this);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::authAnswered(Response<BUFFER> &response)
+{
+	status.is_authenticating = false;
+	if (response.header.code == 0) {
+		LOG_DEBUG("Authenticated as ", m_User);
+		return;
+	}
+	std::string msg = "Authentication failed";
+	if (response.body.error_stack != std::nullopt) {
+		const auto &error = response.body.error_stack->error;
+		msg += std::string(": ") + std::string(error.msg, error.msg_len);
+	}
+	LOG_ERROR(msg);
+	/* Credentials are wrong, there's no point in reconnecting. */
+	m_Address.clear();
+	setError(msg);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::requestExpired(rid_t sync)
+{
+	LOG_DEBUG("Request ", sync, " is timed out");
+	if (! m_Unanswered.empty())
+		requestAnswered(sync);
+	m_Stats.requestTimedOut();
+	deliverError(sync, Iproto::ER_TIMEOUT, "Request is timed out");
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::setReconnectPolicy(const ReconnectPolicy &policy)
+{
+	m_ReconnectPolicy = policy;
+	if (! m_ReconnectPolicy.isEnabled())
+		m_Unanswered.clear();
+}
+
+template<class BUFFER, class NetProvider>
+typename Connection<BUFFER, NetProvider>::UnansweredRequest *
+Connection<BUFFER, NetProvider>::findUnanswered(rid_t sync)
+{
+	auto it = std::lower_bound(m_Unanswered.begin(), m_Unanswered.end(),
+				   sync, [](const UnansweredRequest &r, rid_t s) {
+		return r.sync < s;
+	});
+	if (it == m_Unanswered.end() || it->sync != sync)
+		return nullptr;
+	return &*it;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::setReplayable(rid_t future)
+{
+	UnansweredRequest *request = findUnanswered(future);
+	if (request != nullptr)
+		request->is_replayable = true;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::requestAnswered(rid_t sync)
+{
+	/* Responses mostly come in order, so the front is checked first. */
+	UnansweredRequest *request = m_Unanswered.front().sync == sync ?
+				     &m_Unanswered.front() :
+				     findUnanswered(sync);
+	if (request == nullptr)
+		return;
+	request->is_answered = true;
+	while (! m_Unanswered.empty() && m_Unanswered.front().is_answered)
+		m_Unanswered.pop_front();
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::dropUndecoded()
+{
+	m_Decoder.reset(m_EndDecoded);
+	size_t undecoded = m_InBuf.end() - m_EndDecoded;
+	if (undecoded != 0)
+		m_InBuf.dropBack(undecoded);
+	if (status.is_ready_to_decode) {
+		status.is_ready_to_decode = false;
+		rlist_del(&m_in_read);
+	}
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::failLostRequests(bool can_replay)
+{
+	/* Rest of the response is never going to be received. */
+	dropUndecoded();
+	status.is_authenticating = false;
+	/* Copy unsent replayable requests, drop the rest of output. */
+	std::string replay;
+	std::deque<UnansweredRequest> kept;
+	std::vector<std::pair<rid_t, const char *>> failed;
+	/* Requests which are not tracked for replay are lost for sure. */
+	m_Pending.forEach([this, &failed](size_t sync, PendingRequest &) {
+		if (m_Unanswered.empty() || findUnanswered(sync) == nullptr)
+			failed.emplace_back(sync, "Connection is lost");
+	});
+	/* So are requests tracked by their handlers only. */
+	if (m_HandledOnly != 0) {
+		m_Handlers.forEach([this, &failed](size_t sync, HandledRequest &) {
+			if (m_Pending.find(sync) == nullptr)
+				failed.emplace_back(sync, "Connection is lost");
+		});
+		m_HandledOnly = 0;
+	}
+	for (const UnansweredRequest &r : m_Unanswered) {
+		if (r.is_answered)
+			continue;
+		uint64_t begin = r.end - r.size;
+		if (begin < m_SentBytes) {
+			failed.emplace_back(r.sync, r.end > m_SentBytes ?
+				"Connection is lost, request is not sent" :
+				"Connection is lost, request may have been executed");
+			continue;
+		}
+		bool is_replayable = ! r.is_in_stream && (r.is_replayable ||
+			m_ReconnectPolicy.replay == ReconnectPolicy::REPLAY_ALL ||
+			(m_ReconnectPolicy.replay == ReconnectPolicy::REPLAY_IDEMPOTENT &&
+			 (r.type == Iproto::PING || r.type == Iproto::SELECT)));
+		if (! can_replay || ! is_replayable) {
+			failed.emplace_back(r.sync,
+				"Connection is lost, request is not sent");
+			continue;
+		}
+		size_t offset = replay.size();
+		replay.resize(offset + r.size);
+		iterator itr = m_OutBuf.begin() + (begin - m_SentBytes);
+		m_OutBuf.get(itr, &replay[offset], r.size);
+		kept.push_back(r);
+	}
+	size_t unsent = m_EndEncoded - m_OutBuf.begin();
+	if (unsent != 0) {
+		m_OutBuf.dropFront(unsent);
+		m_SentBytes += unsent;
+	}
+	if (! rlist_empty(&m_in_write)) {
+		rlist_del(&m_in_write);
+		status.is_ready_to_send = false;
+	}
+	if (! replay.empty()) {
+		m_OutBuf.addBack(wrap::Data{replay.data(), replay.size()});
+		m_EndEncoded += replay.size();
+	}
+	uint64_t end = m_SentBytes;
+	for (UnansweredRequest &r : kept) {
+		end += r.size;
+		r.end = end;
+	}
+	m_Unanswered = std::move(kept);
+	if (! rlist_empty(&m_in_hold))
+		rlist_del(&m_in_hold);
+	m_HeldRequests = 0;
+	/* State is consistent, so handlers may issue new requests. */
+	for (const auto &[sync, msg] : failed) {
+		m_Stats.requestFailed();
+		deliverError(sync, Iproto::ER_NO_CONNECTION, msg);
+	}
+}
+
+template<class BUFFER, class NetProvider>
+const ConnectionStat&
+Connection<BUFFER, NetProvider>::getStat() const
+{
+	return m_Stats.stat();
+}
+
+template<class BUFFER, class NetProvider>
+const LatencyHistogram *
+Connection<BUFFER, NetProvider>::getLatency(uint32_t type) const
+{
+	return m_Stats.latency(type);
+}
+
+template<class BUFFER, class NetProvider>
+typename Connection<BUFFER, NetProvider>::PendingRequest *
+Connection<BUFFER, NetProvider>::trackPending(rid_t future)
+{
+	HandledRequest *handled = m_Handlers.find(future);
+	if (handled == nullptr)
+		return nullptr;
+	PendingRequest *request = m_Pending.emplace(future, this, future);
+	static_cast<RequestStamp_t &>(*request) = *handled;
+	m_HandledOnly--;
+	return request;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::requestEncoded(uint32_t type)
+{
+	rid_t sync = m_Encoder.getSync();
+	RequestStamp_t *stamp;
+	/* Request which can't expire or be replayed needs handler only. */
+	if (m_EncodedHandler != nullptr && m_RequestTimeout.count() == 0 &&
+	    ! m_ReconnectPolicy.isEnabled()) {
+		stamp = m_Handlers.emplace(sync, std::move(*m_EncodedHandler));
+		m_HandledOnly++;
+	} else {
+		stamp = m_Pending.emplace(sync, this, sync);
+		if (m_EncodedHandler != nullptr)
+			m_Handlers.emplace(sync, std::move(*m_EncodedHandler));
+	}
+	m_EncodedHandler = nullptr;
+	assert(stamp != nullptr);
+	m_Stats.requestEncoded(*stamp, type);
+	/* Request is failed by the next wait, nothing is going to be sent. */
+	if (status.is_failed && ! isReconnecting()) {
+		m_Connector.connectionFailed(*this);
+		return;
+	}
+	if (m_RequestTimeout.count() != 0)
+		setDeadline(sync,
+			    std::chrono::steady_clock::now() + m_RequestTimeout);
+	if (m_ReconnectPolicy.isEnabled()) {
+		uint64_t end = m_SentBytes + (m_EndEncoded - m_OutBuf.begin());
+		uint64_t begin = m_Unanswered.empty() ?
+				 m_SentBytes : m_Unanswered.back().end;
+		m_Unanswered.push_back({sync, end,
+					(uint32_t) (end - begin), type,
+					false, false,
+					m_Encoder.getStreamId() != 0});
+	}
+	/* Lost connection keeps requests until it is restored. */
+	if (isReconnecting())
+		return;
+	if (! m_IsCorked && ! m_FlushPolicy.isEnabled()) {
+		m_Stats.flushed(1, nullptr);
+		m_Connector.readyToSend(*this);
+		return;
+	}
+	if (m_HeldRequests++ == 0) {
+		m_Connector.holdRequests(*this);
+		if (m_FlushPolicy.delay.count() != 0)
+			m_HeldSince = std::chrono::steady_clock::now();
+	}
+	if (m_IsCorked)
+		return;
+	if (m_FlushPolicy.requests != 0 &&
+	    m_HeldRequests >= m_FlushPolicy.requests) {
+		releaseHeld(&ConnectionStat::flush_by_requests);
+	} else if (m_FlushPolicy.bytes != 0 &&
+		   (size_t) (m_EndEncoded - m_OutBuf.begin()) >= m_FlushPolicy.bytes) {
+		releaseHeld(&ConnectionStat::flush_by_bytes);
+	} else if (m_FlushPolicy.delay.count() != 0 &&
+		   std::chrono::steady_clock::now() - m_HeldSince >= m_FlushPolicy.delay) {
+		releaseHeld(&ConnectionStat::flush_by_delay);
+	}
+}
+
+/**
+ * Queue held requests to be sent. @a reason points to the statistics
+ * counter of the flush reason.
+ */
+template<class BUFFER, class NetProvider>
+void
+Connection<BUFFER, NetProvider>::releaseHeld(size_t ConnectionStat::*reason)
+{
+	if (m_HeldRequests == 0)
+		return;
+	m_Stats.flushed(m_HeldRequests, reason);
+	m_HeldRequests = 0;
+	m_Connector.readyToSend(*this);
+}
+
+/**
+ * Double iovec array unless it has already reached MAX_IOVEC_COUNT.
+ * Return false if the array can't grow anymore.
+ */
+template<class BUFFER, class NetProvider>
+bool
+Connection<BUFFER, NetProvider>::growIOV()
+{
+	if (m_IOVecs.size() >= MAX_IOVEC_COUNT)
+		return false;
+	m_IOVecs.resize(std::min(m_IOVecs.size() * 2, MAX_IOVEC_COUNT));
+	return true;
+}
+
 
 #ifndef NDEBUG
 template<class BUFFER, class NetProvider>
@@ -453,12 +1642,13 @@ inBufferToIOV(Connection<BUFFER, NetProvider> &conn, size_t size, size_t *iov_le
 {
 	assert(iov_len != NULL);
 	BUFFER &buf = conn.m_InBuf;
-	struct iovec *vecs = conn.m_IOVecs;
+	std::vector<struct iovec> &vecs = conn.m_IOVecs;
 	typename BUFFER::iterator itr = buf.end();
 	buf.addBack(wrap::Advance{size});
-	*iov_len = buf.getIOV(itr, vecs,
-			      Connection<BUFFER, NetProvider>::AVAILABLE_IOVEC_COUNT);
-	return vecs;
+	do {
+		*iov_len = buf.getIOV(itr, vecs.data(), vecs.size());
+	} while (*iov_len == vecs.size() && conn.growIOV());
+	return vecs.data();
 }
 
 template<class BUFFER, class NetProvider>
@@ -467,10 +1657,12 @@ outBufferToIOV(Connection<BUFFER, NetProvider> &conn, size_t *iov_len)
 {
 	assert(iov_len != NULL);
 	BUFFER &buf = conn.m_OutBuf;
-	struct iovec *vecs = conn.m_IOVecs;
-	*iov_len = buf.getIOV(buf.begin(), conn.m_EndEncoded, vecs,
-			      Connection<BUFFER, NetProvider>::AVAILABLE_IOVEC_COUNT);
-	return vecs;
+	std::vector<struct iovec> &vecs = conn.m_IOVecs;
+	do {
+		*iov_len = buf.getIOV(buf.begin(), conn.m_EndEncoded,
+				      vecs.data(), vecs.size());
+	} while (*iov_len == vecs.size() && conn.growIOV());
+	return vecs.data();
 }
 
 template<class BUFFER, class NetProvider>
@@ -479,6 +1671,7 @@ hasSentBytes(Connection<BUFFER, NetProvider> &conn, size_t bytes)
 {
 	if (bytes > 0)
 		conn.m_OutBuf.dropFront(bytes);
+	conn.m_SentBytes += bytes;
 	if (! hasDataToSend(conn)) {
 		conn.status.is_ready_to_send = false;
 		rlist_del(&conn.m_in_write);
@@ -494,6 +1687,26 @@ hasNotRecvBytes(Connection<BUFFER, NetProvider> &conn, size_t bytes)
 		conn.m_InBuf.dropBack(bytes);
 }
 
+/**
+ * Account send syscall (or io_uring operation) of @a iov_cnt vectors
+ * @a iov which has returned @a rc.
+ */
+template<class BUFFER, class NetProvider>
+void
+statSendCall(Connection<BUFFER, NetProvider> &conn, const struct iovec *iov,
+	     size_t iov_cnt, ssize_t rc)
+{
+	conn.m_Stats.sendCalled(iov, iov_cnt, rc);
+}
+
+/** Account receive syscall (or io_uring operation) which returned @a rc. */
+template<class BUFFER, class NetProvider>
+void
+statRecvCall(Connection<BUFFER, NetProvider> &conn, ssize_t rc)
+{
+	conn.m_Stats.recvCalled(rc);
+}
+
 template<class BUFFER, class NetProvider>
 bool
 hasDataToSend(Connection<BUFFER, NetProvider> &conn)
@@ -508,12 +1721,29 @@ hasDataToDecode(Connection<BUFFER, NetProvider> &conn)
 	return conn.m_EndDecoded != conn.m_InBuf.end();
 }
 
+/**
+ * Rest of the response is not received yet: connection is queued to be
+ * decoded again by network provider once more data arrives.
+ */
+template<class BUFFER, class NetProvider>
+static inline DecodeStatus
+decodeNeedMore(Connection<BUFFER, NetProvider> &conn)
+{
+	if (conn.status.is_ready_to_decode) {
+		conn.status.is_ready_to_decode = false;
+		rlist_del(&conn.m_in_read);
+	}
+	return DECODE_NEEDMORE;
+}
+
 template<class BUFFER, class NetProvider>
 DecodeStatus
 decodeResponse(Connection<BUFFER, NetProvider> &conn)
 {
-	static int gc_step = 0;
 	Response<BUFFER> response;
+	/* Response may be split even inside of its size prefix. */
+	if (! conn.m_InBuf.has(conn.m_EndDecoded, MP_RESPONSE_SIZE))
+		return decodeNeedMore(conn);
 	response.size = conn.m_Decoder.decodeResponseSize();
 	if (response.size < 0) {
 		conn.setError("Failed to decode response size");
@@ -522,7 +1752,7 @@ decodeResponse(Connection<BUFFER, NetProvider> &conn)
 	response.size += MP_RESPONSE_SIZE;
 	if (! conn.m_InBuf.has(conn.m_EndDecoded, response.size)) {
 		conn.m_Decoder.reset(conn.m_EndDecoded);
-		return DECODE_NEEDMORE;
+		return decodeNeedMore(conn);
 	}
 	if (conn.m_Decoder.decodeResponse(response) != 0) {
 		conn.setError("Failed to decode response, skipping bytes..");
@@ -531,19 +1761,65 @@ decodeResponse(Connection<BUFFER, NetProvider> &conn)
 	}
 	LOG_DEBUG("Header: sync=", response.header.sync, ", code=",
 		  response.header.code, ", schema=", response.header.schema_id);
-	std::size_t response_size = response.size;
-	conn.m_Futures.insert({response.header.sync, std::move(response)});
-	conn.m_EndDecoded += response_size;
-	if ((gc_step++ % Connection<BUFFER, NetProvider>::GC_STEP_CNT) == 0)
+	if (conn.status.is_authenticating &&
+	    (rid_t) response.header.sync == conn.m_AuthSync) {
+		conn.m_EndDecoded += response.size;
+		if (! hasDataToDecode(conn)) {
+			conn.status.is_ready_to_decode = false;
+			rlist_del(&conn.m_in_read);
+		}
+		conn.authAnswered(response);
+		return DECODE_SUCC;
+	}
+	/* Future of expired request is already completed with error. */
+	auto *request = conn.m_Pending.find(response.header.sync);
+	const RequestStamp_t *stamp = request;
+	/* Request made with handler may be tracked by the handler only. */
+	if (request == nullptr && conn.m_HandledOnly != 0) {
+		stamp = conn.m_Handlers.find(response.header.sync);
+		if (stamp != nullptr)
+			conn.m_HandledOnly--;
+	}
+	bool is_pending = stamp != nullptr;
+	/* Late response is counted, but it has no latency. */
+	conn.m_Stats.responseDecoded(stamp);
+	if (request != nullptr) {
+		conn.m_Pending.erase(response.header.sync);
+		if (! conn.m_Unanswered.empty())
+			conn.requestAnswered(response.header.sync);
+	}
+	conn.m_EndDecoded += response.size;
+	if ((conn.m_GCStep++ % Connection<BUFFER, NetProvider>::GC_STEP_CNT) == 0)
 		conn.m_InBuf.flush();
 	if (! hasDataToDecode(conn)) {
 		conn.status.is_ready_to_decode = false;
 		rlist_del(&conn.m_in_read);
 		LOG_DEBUG("Removed ", &conn.m_in_write, " from the read list");
 	}
+	/*
+	 * Connection state is consistent by now, so handler is free to
+	 * issue new requests (e.g. resume a coroutine which does so).
+	 */
+	uint64_t schema_version = conn.m_Schema.getVersion();
+	if (schema_version != 0 && conn.m_SchemaRequests == 0 &&
+	    response.header.schema_id > 0 &&
+	    (uint64_t) response.header.schema_id != schema_version)
+		conn.fetchSchema();
+	if (is_pending)
+		conn.deliverResponse(response);
 	return DECODE_SUCC;
 }
 
+/** Count of greeting bytes which are not received yet. */
+template<class BUFFER, class NetProvider>
+size_t
+greetingBytesLeft(Connection<BUFFER, NetProvider> &conn)
+{
+	size_t received = conn.m_InBuf.end() - conn.m_EndDecoded;
+	assert(received <= Iproto::GREETING_SIZE);
+	return Iproto::GREETING_SIZE - received;
+}
+
 template<class BUFFER, class NetProvider>
 int
 decodeGreeting(Connection<BUFFER, NetProvider> &conn)
@@ -558,6 +1834,8 @@ decodeGreeting(Connection<BUFFER, NetProvider> &conn)
 			  conn.m_Greeting) != 0)
 		return -1;
 	LOG_DEBUG("Version: ", conn.m_Greeting.version_id);
+	/* Statements prepared in previous session are gone. */
+	conn.m_Statements.clear();
 
 #ifndef NDEBUG
 	//print salt in hex format.
@@ -571,5 +1849,7 @@ decodeGreeting(Connection<BUFFER, NetProvider> &conn)
 	hex_salt[conn.m_Greeting.salt_size * 2] = 0;
 	LOG_DEBUG("Salt: ", hex_salt);
 #endif
+	if (! conn.m_User.empty())
+		conn.authenticate();
 	return 0;
 }
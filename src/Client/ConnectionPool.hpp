@@ -0,0 +1,209 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "Connector.hpp"
+
+#include <memory>
+#include <vector>
+
+/**
+ * Pool of connections (possibly to several endpoints) of one Connector.
+ * Each request is routed to the alive connection with the least count of
+ * requests in flight, so that several connections to an instance can
+ * keep more of its iproto threads busy. Responses are collected by
+ * the connector as usual, so waiting on the pool connections can be
+ * mixed with other connections of the connector.
+ */
+template<class BUFFER, class NetProvider = DefaultNetProvider<BUFFER, NetworkEngine>>
+class ConnectionPool
+{
+public:
+	using Conn_t = Connection<BUFFER, NetProvider>;
+
+	explicit ConnectionPool(Connector<BUFFER, NetProvider> &connector) :
+		m_Connector(connector), m_Next(0) {}
+	~ConnectionPool();
+	ConnectionPool(const ConnectionPool &) = delete;
+	ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+	/**
+	 * Open @a conn_count connections to the endpoint and add them to
+	 * the pool. Connections are established in parallel. Return 0 on
+	 * success, -1 if any of them failed (the ones which are established
+	 * are kept in the pool).
+	 */
+	int connect(const std::string_view &addr, unsigned port,
+		    size_t conn_count,
+		    size_t timeout = Connector<BUFFER, NetProvider>::DEFAULT_CONNECT_TIMEOUT);
+	void close();
+
+	/**
+	 * Connection to route the next request to: the one with the least
+	 * requests in flight. Ties are broken in round-robin manner. Failed
+	 * connections are skipped; nullptr if there's no alive connection.
+	 */
+	Conn_t *get();
+	size_t size() const { return m_Conns.size(); }
+	Conn_t &operator[](size_t i) { return *m_Conns[i]; }
+	/** Total count of requests in flight over all the connections. */
+	size_t getInFlight() const;
+
+	/**
+	 * Wait until responses to all requests sent via the pool are
+	 * decoded. Requests of a connection which fails meanwhile are
+	 * completed with ER_NO_CONNECTION error. Return 0 on success, -1 on
+	 * timeout or if some connection has failed (and is not going to be
+	 * restored).
+	 */
+	int waitAll(int timeout = 0);
+private:
+	bool contains(const Conn_t &conn) const;
+
+	Connector<BUFFER, NetProvider> &m_Connector;
+	std::vector<std::unique_ptr<Conn_t>> m_Conns;
+	/** Where get() starts to look for the least loaded connection. */
+	size_t m_Next;
+};
+
+template<class BUFFER, class NetProvider>
+ConnectionPool<BUFFER, NetProvider>::~ConnectionPool()
+{
+	close();
+}
+
+template<class BUFFER, class NetProvider>
+int
+ConnectionPool<BUFFER, NetProvider>::connect(const std::string_view &addr,
+					     unsigned port, size_t conn_count,
+					     size_t timeout)
+{
+	size_t first = m_Conns.size();
+	int rc = 0;
+	for (size_t i = 0; i < conn_count; ++i) {
+		std::unique_ptr<Conn_t> conn =
+			std::make_unique<Conn_t>(m_Connector);
+		if (m_Connector.connectAsync(*conn, addr, port, timeout) != 0) {
+			rc = -1;
+			break;
+		}
+		m_Conns.push_back(std::move(conn));
+	}
+	/* Handshakes of all the connections progress during each wait. */
+	for (size_t i = first; i < m_Conns.size(); ) {
+		if (m_Connector.waitConnect(*m_Conns[i]) == 0) {
+			++i;
+			continue;
+		}
+		if (m_Conns[i]->socket >= 0)
+			m_Connector.close(*m_Conns[i]);
+		m_Conns.erase(m_Conns.begin() + i);
+		rc = -1;
+	}
+	return rc;
+}
+
+template<class BUFFER, class NetProvider>
+void
+ConnectionPool<BUFFER, NetProvider>::close()
+{
+	for (std::unique_ptr<Conn_t> &conn : m_Conns) {
+		if (conn->socket >= 0)
+			m_Connector.close(*conn);
+	}
+	m_Conns.clear();
+}
+
+template<class BUFFER, class NetProvider>
+Connection<BUFFER, NetProvider> *
+ConnectionPool<BUFFER, NetProvider>::get()
+{
+	Conn_t *best = nullptr;
+	size_t count = m_Conns.size();
+	for (size_t i = 0; i < count; ++i) {
+		Conn_t *conn = m_Conns[(m_Next + i) % count].get();
+		if (conn->status.is_failed || conn->socket < 0)
+			continue;
+		if (best == nullptr || conn->getInFlight() < best->getInFlight())
+			best = conn;
+		if (best->getInFlight() == 0)
+			break;
+	}
+	if (count != 0)
+		m_Next = (m_Next + 1) % count;
+	return best;
+}
+
+template<class BUFFER, class NetProvider>
+size_t
+ConnectionPool<BUFFER, NetProvider>::getInFlight() const
+{
+	size_t in_flight = 0;
+	for (const std::unique_ptr<Conn_t> &conn : m_Conns)
+		in_flight += conn->getInFlight();
+	return in_flight;
+}
+
+template<class BUFFER, class NetProvider>
+bool
+ConnectionPool<BUFFER, NetProvider>::contains(const Conn_t &conn) const
+{
+	for (const std::unique_ptr<Conn_t> &c : m_Conns) {
+		if (c.get() == &conn)
+			return true;
+	}
+	return false;
+}
+
+template<class BUFFER, class NetProvider>
+int
+ConnectionPool<BUFFER, NetProvider>::waitAll(int timeout)
+{
+	Timer timer{timeout};
+	timer.start();
+	int rc = 0;
+	/* Failed connection is reported once its requests are completed. */
+	auto on_ready = [this, &rc](Conn_t &conn) {
+		if (! conn.status.is_failed || conn.isReconnecting() ||
+		    ! contains(conn))
+			return;
+		LOG_ERROR("Connection ", &conn, " has failed: ", conn.getError());
+		rc = -1;
+	};
+	while (getInFlight() != 0) {
+		if (timer.isExpired()) {
+			LOG_WARNING("ConnectionPool::waitAll() is timed out! ",
+				    getInFlight(), " requests are in flight");
+			return -1;
+		}
+		m_Connector.waitSome(on_ready, timeout - timer.elapsed());
+	}
+	return rc;
+}
@@ -33,6 +33,11 @@
 #include "DefaultNetProvider.hpp"
 #include "../Utils/Timer.hpp"
 
+/**
+ * Connector is not thread-safe. To scale across cores create one
+ * Connector per thread: connections, buffers and network provider of a
+ * Connector must be used only by the thread which owns it.
+ */
 template<class BUFFER, class NetProvider = DefaultNetProvider<BUFFER, NetworkEngine>>
 class Connector
 {
@@ -45,13 +50,50 @@ public:
 	int connect(Connection<BUFFER, NetProvider> &conn,
 		    const std::string_view& addr, unsigned port,
 		    size_t timeout = DEFAULT_CONNECT_TIMEOUT);
+	/**
+	 * Start connecting without blocking. Connect and greeting are
+	 * processed while connector waits, so many connections are
+	 * established in parallel. Requests may be sent right away: they
+	 * are queued until the connection is established. Return -1 if
+	 * connect can't be started at all.
+	 */
+	int connectAsync(Connection<BUFFER, NetProvider> &conn,
+			 const std::string_view& addr, unsigned port,
+			 size_t timeout = DEFAULT_CONNECT_TIMEOUT);
+	/**
+	 * Wait for asynchronous connect to complete. Return 0 if the
+	 * connection is established (and authenticated if credentials are
+	 * set), -1 on failure (the socket is closed then) or timeout.
+	 */
+	int waitConnect(Connection<BUFFER, NetProvider> &conn, int timeout = 0);
 	void close(Connection<BUFFER, NetProvider> &conn);
 
 	int wait(Connection<BUFFER, NetProvider> &conn, rid_t future,
 		 int timeout = 0);
-	void waitAll(Connection<BUFFER, NetProvider> &conn, rid_t *futures,
-		     size_t future_count, int timeout = 0);
+	/**
+	 * Wait for all the futures to be ready. Return 0 on success, -1
+	 * on timeout or connection failure. If @a ready is not null, it is
+	 * filled with per-future readiness (handled futures are ready once
+	 * their handlers are called).
+	 */
+	int waitAll(Connection<BUFFER, NetProvider> &conn, rid_t *futures,
+		    size_t future_count, int timeout = 0,
+		    bool *ready = nullptr);
 	Connection<BUFFER, NetProvider>* waitAny(int timeout = 0);
+	/**
+	 * Wait until at least one connection has responses, decode
+	 * responses of all such connections and invoke @a on_ready for each
+	 * of them. Return number of ready connections (0 on timeout).
+	 * @a on_ready is free to send requests and wait on the connector.
+	 * Connection which has failed (and is not going to be restored) is
+	 * reported as well: its requests in flight are completed with
+	 * ER_NO_CONNECTION error. The same applies to waitAny().
+	 */
+	template<class ON_READY>
+	size_t waitSome(ON_READY &&on_ready, int timeout = 0);
+	/** Same as above, but @a ready is filled with ready connections. */
+	size_t waitSome(std::vector<Connection<BUFFER, NetProvider> *> &ready,
+			int timeout = 0);
 
 	/**
 	 * Add to @m_ready_to_read queue and parse response.
@@ -59,6 +101,18 @@ public:
 	 * */
 	void readyToDecode(Connection<BUFFER, NetProvider> &conn);
 	void readyToSend(Connection<BUFFER, NetProvider> &conn);
+	/** Add to @m_held list: connection keeps encoded requests. */
+	void holdRequests(Connection<BUFFER, NetProvider> &conn);
+	/** Send encoded requests of the connection without waiting. */
+	void flush(Connection<BUFFER, NetProvider> &conn);
+	/** Access network provider to tune its settings. */
+	NetProvider &getNetProvider() { return m_NetProvider; }
+	/** Statistics aggregated over all connections of the connector. */
+	const ConnectionStat &getStat() const { return m_Stats.stat(); }
+	const LatencyHistogram *getLatency(uint32_t type) const
+	{
+		return m_Stats.latency(type);
+	}
 
 	constexpr static size_t DEFAULT_CONNECT_TIMEOUT = 2;
 private:
@@ -68,12 +122,73 @@ private:
 	 * requests or read responses.
 	 */
 	struct rlist m_ready_to_read;
+	/**
+	 * Connections holding requests according to their flush policy.
+	 * Held requests are queued to be sent when connector waits.
+	 */
+	struct rlist m_held;
+	/** Failed connections which are going to be restored. */
+	struct rlist m_reconnecting;
+	ConnectionStats_t m_Stats;
+	using Pending_t = typename Connection<BUFFER, NetProvider>::PendingRequest;
+	/** Request deadlines, one tick is a millisecond since m_Epoch. */
+	tnt::TimerWheel<Pending_t> m_DeadlineWheel;
+	std::chrono::steady_clock::time_point m_Epoch;
+
+	void releaseHeld();
+	/** Check that @a conn may be connected and remember its address. */
+	bool canConnect(Connection<BUFFER, NetProvider> &conn);
+	void setAddress(Connection<BUFFER, NetProvider> &conn,
+			const std::string_view& addr, unsigned port,
+			size_t timeout);
+	/** Invoked by Connection which has failed under reconnect policy. */
+	void connectionLost(Connection<BUFFER, NetProvider> &conn);
+	/**
+	 * Invoked by Connection which has failed for good. If it has
+	 * requests in flight, it's queued as ready to decode, so that wait
+	 * methods complete the requests with error and report it.
+	 */
+	void connectionFailed(Connection<BUFFER, NetProvider> &conn);
+	/** Make an attempt to restore each connection which is due. */
+	void processReconnects();
+	void reconnect(Connection<BUFFER, NetProvider> &conn);
+	/** Plan the next attempt according to backoff. */
+	void scheduleReconnect(Connection<BUFFER, NetProvider> &conn);
+	/** Shorten @a timeout so that wait wakes up for the next attempt. */
+	int reconnectTimeout(int timeout);
+	void addDeadline(Pending_t &request,
+			 std::chrono::steady_clock::time_point at);
+	/** Complete requests whose deadlines have come with error. */
+	void processDeadlines();
+	/** Process both reconnects and deadlines which are due. */
+	void processTimers();
+	/** Shorten @a timeout so that wait wakes up for the nearest timer. */
+	int timersTimeout(int timeout);
+	/**
+	 * Decode all received responses. Requests of failed connection
+	 * which are left unanswered are completed with ER_NO_CONNECTION.
+	 * Return -1 on decode error.
+	 */
+	int decodeReady(Connection<BUFFER, NetProvider> &conn);
+	/**
+	 * Drive network provider until @a is_ready() returns true. The
+	 * connection is checked to be alive only once and only if it has
+	 * to wait for the network at all.
+	 */
+	template<class READY>
+	int waitUntil(Connection<BUFFER, NetProvider> &conn,
+		      READY &&is_ready, int timeout);
+
+	friend class Connection<BUFFER, NetProvider>;
 };
 
 template<class BUFFER, class NetProvider>
-Connector<BUFFER, NetProvider>::Connector() : m_NetProvider()
+Connector<BUFFER, NetProvider>::Connector() : m_NetProvider(),
+	m_Epoch(std::chrono::steady_clock::now())
 {
 	rlist_create(&m_ready_to_read);
+	rlist_create(&m_held);
+	rlist_create(&m_reconnecting);
 }
 
 template<class BUFFER, class NetProvider>
@@ -82,23 +197,85 @@ Connector<BUFFER, NetProvider>::~Connector()
 	assert(rlist_empty(&m_ready_to_read));
 }
 
+template<class BUFFER, class NetProvider>
+bool
+Connector<BUFFER, NetProvider>::canConnect(Connection<BUFFER, NetProvider> &conn)
+{
+	if (conn.socket >= 0 && m_NetProvider.check(conn)) {
+		LOG_ERROR("Current connection to ", conn.socket, " is alive! "
+			"Please close it before connecting to the new address");
+		return false;
+	}
+	return true;
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::setAddress(Connection<BUFFER, NetProvider> &conn,
+					   const std::string_view& addr,
+					   unsigned port, size_t timeout)
+{
+	if (! rlist_empty(&conn.m_in_reconnect))
+		rlist_del(&conn.m_in_reconnect);
+	conn.m_Address = addr;
+	conn.m_Port = port;
+	conn.m_ConnectTimeout = timeout;
+	conn.m_ReconnectAttempts = 0;
+}
+
 template<class BUFFER, class NetProvider>
 int
 Connector<BUFFER, NetProvider>::connect(Connection<BUFFER, NetProvider> &conn,
 					const std::string_view& addr,
 					unsigned port, size_t timeout)
 {
-	if (conn.socket >= 0 && m_NetProvider.check(conn)) {
-		LOG_ERROR("Current connection to ", conn.socket, " is alive! "
-			"Please close it before connecting to the new address");
+	if (! canConnect(conn))
 		return -1;
-	}
 	if (m_NetProvider.connect(conn, addr, port, timeout) != 0) {
 		LOG_ERROR("Failed to connect to ", addr, ':', port);
 		LOG_ERROR("Reason: ", conn.getError());
 		return -1;
 	}
 	LOG_DEBUG("Connected to ", addr, ':', port, " has been established");
+	setAddress(conn, addr, port, timeout);
+	return 0;
+}
+
+template<class BUFFER, class NetProvider>
+int
+Connector<BUFFER, NetProvider>::connectAsync(Connection<BUFFER, NetProvider> &conn,
+					     const std::string_view& addr,
+					     unsigned port, size_t timeout)
+{
+	if (! canConnect(conn))
+		return -1;
+	if (m_NetProvider.connectAsync(conn, addr, port, timeout) != 0) {
+		LOG_ERROR("Failed to connect to ", addr, ':', port);
+		LOG_ERROR("Reason: ", conn.getError());
+		return -1;
+	}
+	setAddress(conn, addr, port, timeout);
+	return 0;
+}
+
+template<class BUFFER, class NetProvider>
+int
+Connector<BUFFER, NetProvider>::waitConnect(Connection<BUFFER, NetProvider> &conn,
+					    int timeout)
+{
+	auto is_ready = [&conn]() {
+		return ! conn.status.is_connecting &&
+		       ! conn.status.is_authenticating &&
+		       ! conn.isReconnecting();
+	};
+	if (waitUntil(conn, is_ready, timeout) != 0 || conn.status.is_failed) {
+		LOG_ERROR("Failed to connect: ", conn.getError());
+		/* Connect which has failed (not timed out) can't proceed. */
+		if (conn.status.is_failed && conn.socket >= 0 &&
+		    ! conn.isReconnecting())
+			m_NetProvider.close(conn);
+		return -1;
+	}
 	return 0;
 }
 
@@ -106,6 +283,10 @@ template<class BUFFER, class NetProvider>
 void
 Connector<BUFFER, NetProvider>::close(Connection<BUFFER, NetProvider> &conn)
 {
+	/* Connection closed explicitly is not restored. */
+	conn.m_Address.clear();
+	if (! rlist_empty(&conn.m_in_reconnect))
+		rlist_del(&conn.m_in_reconnect);
 	m_NetProvider.close(conn);
 }
 
@@ -115,74 +296,133 @@ Connector<BUFFER, NetProvider>::wait(Connection<BUFFER, NetProvider> &conn,
 				     rid_t future, int timeout)
 {
 	LOG_DEBUG("Waiting for the future ", future, " with timeout ", timeout);
-	Timer timer{timeout};
-	timer.start();
+	/*
+	 * Response of handled future is passed to handler and never
+	 * stored, so wait for the handler to be called.
+	 */
+	bool is_handled = conn.m_Handlers.find(future) != nullptr;
+	auto is_ready = [&conn, future, is_handled]() {
+		return is_handled ? conn.m_Handlers.find(future) == nullptr :
+				    conn.futureIsReady(future);
+	};
+	if (waitUntil(conn, is_ready, timeout) != 0) {
+		if (! conn.status.is_failed)
+			LOG_ERROR("Connection has been timed out: future ",
+				  future, " is not ready");
+		return -1;
+	}
+	LOG_DEBUG("Feature ", future, " is ready and decoded");
+	return 0;
+}
+
+template<class BUFFER, class NetProvider>
+int
+Connector<BUFFER, NetProvider>::decodeReady(Connection<BUFFER, NetProvider> &conn)
+{
+	int rc = 0;
 	while (hasDataToDecode(conn)) {
-		if (conn.status.is_failed) {
-			LOG_ERROR("Connection has failed. Please, handle error"
-				  "and reset connection status.");
-			return -1;
+		DecodeStatus status = decodeResponse(conn);
+		if (status == DECODE_ERR) {
+			rc = -1;
+			break;
 		}
-		DecodeStatus rc = decodeResponse(conn);
-		if (rc == DECODE_ERR)
-			return -1;
-		if (rc == DECODE_NEEDMORE)
+		if (status == DECODE_NEEDMORE)
 			break;
 	}
-	if (! m_NetProvider.check(conn)) {
+	if (conn.status.is_failed && ! conn.isReconnecting())
+		conn.failLostRequests(false);
+	return rc;
+}
+
+template<class BUFFER, class NetProvider>
+template<class READY>
+int
+Connector<BUFFER, NetProvider>::waitUntil(Connection<BUFFER, NetProvider> &conn,
+					  READY &&is_ready, int timeout)
+{
+	Timer timer{timeout};
+	timer.start();
+	if (! conn.m_IsCorked)
+		conn.releaseHeld(&ConnectionStat::flush_by_wait);
+	processTimers();
+	if (conn.status.is_failed && ! conn.isReconnecting()) {
+		decodeReady(conn);
+		LOG_ERROR("Connection has failed. Please, handle error"
+			  "and reset connection status.");
+		return -1;
+	}
+	if (decodeReady(conn) != 0 && ! conn.isReconnecting())
+		return -1;
+	if (is_ready())
+		return 0;
+	/* Failed check() schedules reconnect under reconnect policy. */
+	if (! conn.isReconnecting() && ! m_NetProvider.check(conn) &&
+	    ! conn.isReconnecting()) {
 		LOG_ERROR("Connection has been lost: ", conn.getError(),
 			  ". Please re-connect to the host");
 		return -1;
 	}
-	while (! conn.futureIsReady(future) && !timer.isExpired()) {
-		if (m_NetProvider.wait(timeout - timer.elapsed()) != 0) {
+	while (! is_ready() && !timer.isExpired()) {
+		int left = timersTimeout(timeout - timer.elapsed());
+		if (m_NetProvider.wait(left) != 0) {
 			return -1;
 		}
+		processTimers();
+		if (conn.isReconnecting())
+			continue;
+		if (conn.status.is_ready_to_decode && decodeReady(conn) != 0)
+			return -1;
+		/* Futures of the connection given up on fail with error. */
 		if (conn.status.is_failed != 0) {
 			LOG_ERROR("Connection got error during wait: ",
 				  conn.getError());
 			return -1;
 		}
-		if (conn.status.is_ready_to_decode) {
-			while (hasDataToDecode(conn)) {
-				DecodeStatus rc = decodeResponse(conn);
-				if (rc == DECODE_ERR)
-					return -1;
-				if (rc == DECODE_NEEDMORE)
-					break;
-			}
-		}
-	}
-	if (! conn.futureIsReady(future)) {
-		LOG_ERROR("Connection has been timed out: future ", future,
-			  " is not ready");
-		return -1;
 	}
-	LOG_DEBUG("Feature ", future, " is ready and decoded");
-	return 0;
+	return is_ready() ? 0 : -1;
 }
 
 template<class BUFFER, class NetProvider>
-void
+int
 Connector<BUFFER, NetProvider>::waitAll(Connection<BUFFER, NetProvider> &conn,
 					rid_t *futures, size_t future_count,
-					int timeout)
+					int timeout, bool *ready)
 {
-	Timer timer{timeout};
-	timer.start();
-	for (size_t i = 0; i < future_count && !timer.isExpired(); ++i) {
-		if (wait(conn, futures[i], timeout - timer.elapsed()) != 0) {
-			conn.setError("Failed to poll: " + std::to_string(errno));
-			return;
-		}
-		if (conn.status.is_failed) {
-			LOG_ERROR("wait() on connection ", &conn, ' ', conn.getError(), " has failed:");
-		}
-		if (timer.isExpired()) {
-			LOG_WARNING("waitAll() is timed out! Only ", i, " futures are handled");
-			return;
-		}
+	/*
+	 * Handlers of the futures may be called while waiting for preceding
+	 * ones, so remember which of them are handled beforehand.
+	 */
+	std::vector<bool> is_handled;
+	if (conn.m_Handlers.size() != 0) {
+		is_handled.resize(future_count);
+		for (size_t i = 0; i < future_count; ++i)
+			is_handled[i] = conn.m_Handlers.find(futures[i]) != nullptr;
 	}
+	auto future_is_ready = [&](size_t i) {
+		if (! is_handled.empty() && is_handled[i])
+			return conn.m_Handlers.find(futures[i]) == nullptr;
+		return conn.futureIsReady(futures[i]);
+	};
+	/*
+	 * All futures before the cursor are ready. Responses mostly come
+	 * in order of requests, so each future is looked up about once
+	 * per waitAll() instead of once per network event.
+	 */
+	size_t cursor = 0;
+	auto all_ready = [&]() {
+		while (cursor < future_count && future_is_ready(cursor))
+			++cursor;
+		return cursor == future_count;
+	};
+	int rc = waitUntil(conn, all_ready, timeout);
+	if (ready != nullptr) {
+		for (size_t i = 0; i < future_count; ++i)
+			ready[i] = i < cursor || future_is_ready(i);
+	}
+	if (rc != 0 && ! conn.status.is_failed)
+		LOG_WARNING("waitAll() is timed out! Only ", cursor,
+			    " futures are handled in order");
+	return rc;
 }
 
 //std::optional with Connection&
@@ -192,32 +432,277 @@ Connector<BUFFER, NetProvider>::waitAny(int timeout)
 {
 	Timer timer{timeout};
 	timer.start();
+	releaseHeld();
+	processTimers();
 	while (rlist_empty(&m_ready_to_read) && !timer.isExpired()) {
-		m_NetProvider.wait(timeout - timer.elapsed());
+		m_NetProvider.wait(timersTimeout(timeout - timer.elapsed()));
+		processTimers();
 	}
+	if (rlist_empty(&m_ready_to_read))
+		return nullptr;
 	using Conn_t = Connection<BUFFER, NetProvider>;
 	Connection<BUFFER, NetProvider> *conn =
 		rlist_first_entry(&m_ready_to_read, Conn_t, m_in_read);
 	assert(conn->status.is_ready_to_decode);
-	while (hasDataToDecode(*conn)) {
-		if (decodeResponse(*conn) != 0)
-			return nullptr;
-	}
+	if (decodeReady(*conn) != 0)
+		return nullptr;
 	return conn;
 }
 
+template<class BUFFER, class NetProvider>
+template<class ON_READY>
+size_t
+Connector<BUFFER, NetProvider>::waitSome(ON_READY &&on_ready, int timeout)
+{
+	Timer timer{timeout};
+	timer.start();
+	releaseHeld();
+	processTimers();
+	while (rlist_empty(&m_ready_to_read) && !timer.isExpired()) {
+		m_NetProvider.wait(timersTimeout(timeout - timer.elapsed()));
+		processTimers();
+	}
+	/*
+	 * Detach the ready connections, so that the ones which get data
+	 * while callbacks are running are left for the next call.
+	 */
+	struct rlist ready;
+	rlist_create(&ready);
+	rlist_splice_tail(&ready, &m_ready_to_read);
+	using Conn_t = Connection<BUFFER, NetProvider>;
+	size_t count = 0;
+	while (! rlist_empty(&ready)) {
+		Conn_t *conn = rlist_first_entry(&ready, Conn_t, m_in_read);
+		assert(conn->status.is_ready_to_decode);
+		/* Drained connection unlinks itself from the list. */
+		if (decodeReady(*conn) != 0)
+			LOG_ERROR("Failed to decode response: ", conn->getError());
+		if (conn->status.is_ready_to_decode)
+			rlist_move_tail(&m_ready_to_read, &conn->m_in_read);
+		++count;
+		on_ready(*conn);
+	}
+	return count;
+}
+
+template<class BUFFER, class NetProvider>
+size_t
+Connector<BUFFER, NetProvider>::waitSome(std::vector<Connection<BUFFER, NetProvider> *> &ready,
+					 int timeout)
+{
+	ready.clear();
+	return waitSome([&ready](Connection<BUFFER, NetProvider> &conn) {
+		ready.push_back(&conn);
+	}, timeout);
+}
+
 template<class BUFFER, class NetProvider>
 void
 Connector<BUFFER, NetProvider>::readyToSend(Connection<BUFFER, NetProvider> &conn)
 {
+	if (! rlist_empty(&conn.m_in_hold))
+		rlist_del(&conn.m_in_hold);
+	/* Requests are sent once the connection is restored. */
+	if (conn.isReconnecting())
+		return;
 	m_NetProvider.readyToSend(conn);
 }
 
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::holdRequests(Connection<BUFFER, NetProvider> &conn)
+{
+	if (rlist_empty(&conn.m_in_hold))
+		rlist_add_tail(&m_held, &conn.m_in_hold);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::releaseHeld()
+{
+	Connection<BUFFER, NetProvider> *conn, *tmp;
+	rlist_foreach_entry_safe(conn, &m_held, m_in_hold, tmp) {
+		if (! conn->m_IsCorked)
+			conn->releaseHeld(&ConnectionStat::flush_by_wait);
+	}
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::connectionLost(Connection<BUFFER, NetProvider> &conn)
+{
+	assert(rlist_empty(&conn.m_in_reconnect));
+	if (conn.status.is_connecting && conn.m_ReconnectAttempts != 0) {
+		/* Handshake of the attempt to restore connection failed. */
+		scheduleReconnect(conn);
+	} else {
+		/*
+		 * Network provider may still refer to the socket, so the
+		 * connection is reset by the next processReconnects()
+		 * rather than right now.
+		 */
+		conn.m_ReconnectAttempts = 0;
+		conn.m_ReconnectAt = std::chrono::steady_clock::now();
+	}
+	rlist_add_tail(&m_reconnecting, &conn.m_in_reconnect);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::connectionFailed(Connection<BUFFER, NetProvider> &conn)
+{
+	if (conn.getInFlight() != 0)
+		readyToDecode(conn);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::scheduleReconnect(Connection<BUFFER, NetProvider> &conn)
+{
+	conn.m_ReconnectAt = std::chrono::steady_clock::now() +
+			     conn.m_ReconnectDelay;
+	conn.m_ReconnectDelay = std::min(conn.m_ReconnectDelay * 2,
+					 conn.m_ReconnectPolicy.max_delay);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::reconnect(Connection<BUFFER, NetProvider> &conn)
+{
+	const ReconnectPolicy &policy = conn.m_ReconnectPolicy;
+	if (conn.socket >= 0)
+		m_NetProvider.close(conn);
+	if (! rlist_empty(&conn.m_in_write))
+		rlist_del(&conn.m_in_write);
+	if (conn.m_ReconnectAttempts == 0) {
+		LOG_WARNING("Connection to ", conn.m_Address, ':', conn.m_Port,
+			    " is lost: ", conn.getError());
+		conn.failLostRequests(true);
+		conn.m_ReconnectDelay = policy.initial_delay;
+	} else if (policy.max_attempts != 0 &&
+		   conn.m_ReconnectAttempts >= policy.max_attempts) {
+		LOG_ERROR("Failed to restore connection to ", conn.m_Address,
+			  ':', conn.m_Port, ": ", conn.getError());
+		rlist_del(&conn.m_in_reconnect);
+		conn.m_Address.clear();
+		conn.failLostRequests(false);
+		return;
+	}
+	conn.m_ReconnectAttempts++;
+	/* Failed attempt may leave a piece of greeting in the buffer. */
+	conn.dropUndecoded();
+	memset(&conn.status, 0, sizeof(conn.status));
+	/* Failure of the handshake is reported by connectionLost(). */
+	if (m_NetProvider.connectAsync(conn, conn.m_Address, conn.m_Port,
+				       conn.m_ConnectTimeout) != 0) {
+		scheduleReconnect(conn);
+		return;
+	}
+	LOG_DEBUG("Restoring connection to ", conn.m_Address, ':', conn.m_Port,
+		  ", attempt ", conn.m_ReconnectAttempts);
+	rlist_del(&conn.m_in_reconnect);
+	if (hasDataToSend(conn))
+		m_NetProvider.readyToSend(conn);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::processReconnects()
+{
+	if (rlist_empty(&m_reconnecting))
+		return;
+	auto now = std::chrono::steady_clock::now();
+	Connection<BUFFER, NetProvider> *conn, *tmp;
+	rlist_foreach_entry_safe(conn, &m_reconnecting, m_in_reconnect, tmp) {
+		if (conn->m_ReconnectAt <= now)
+			reconnect(*conn);
+	}
+}
+
+template<class BUFFER, class NetProvider>
+int
+Connector<BUFFER, NetProvider>::reconnectTimeout(int timeout)
+{
+	if (rlist_empty(&m_reconnecting))
+		return timeout;
+	auto now = std::chrono::steady_clock::now();
+	auto next = std::chrono::steady_clock::time_point::max();
+	Connection<BUFFER, NetProvider> *conn;
+	rlist_foreach_entry(conn, &m_reconnecting, m_in_reconnect)
+		next = std::min(next, conn->m_ReconnectAt);
+	using namespace std::chrono;
+	int left = next <= now ? 1 :
+		   (int) ceil<milliseconds>(next - now).count();
+	left = std::max(left, 1);
+	return timeout <= 0 ? left : std::min(timeout, left);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::addDeadline(Pending_t &request,
+					    std::chrono::steady_clock::time_point at)
+{
+	using namespace std::chrono;
+	/* Round up: request never expires before its deadline. */
+	uint64_t tick = at <= m_Epoch ? 0 :
+			ceil<milliseconds>(at - m_Epoch).count();
+	m_DeadlineWheel.add(request, tick);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::processDeadlines()
+{
+	if (m_DeadlineWheel.nextTick() == UINT64_MAX)
+		return;
+	using namespace std::chrono;
+	uint64_t now = duration_cast<milliseconds>(steady_clock::now() -
+						   m_Epoch).count();
+	if (m_DeadlineWheel.nextTick() > now)
+		return;
+	m_DeadlineWheel.advance(now, [](Pending_t &request) {
+		request.conn->requestExpired(request.sync);
+	});
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::processTimers()
+{
+	processReconnects();
+	processDeadlines();
+}
+
+template<class BUFFER, class NetProvider>
+int
+Connector<BUFFER, NetProvider>::timersTimeout(int timeout)
+{
+	timeout = reconnectTimeout(timeout);
+	uint64_t next = m_DeadlineWheel.nextTick();
+	if (next == UINT64_MAX)
+		return timeout;
+	using namespace std::chrono;
+	uint64_t now = duration_cast<milliseconds>(steady_clock::now() -
+						   m_Epoch).count();
+	int left = next <= now ? 1 : (int) std::min<uint64_t>(next - now, INT_MAX);
+	return timeout <= 0 ? left : std::min(timeout, left);
+}
+
+template<class BUFFER, class NetProvider>
+void
+Connector<BUFFER, NetProvider>::flush(Connection<BUFFER, NetProvider> &conn)
+{
+	if (conn.socket >= 0 && conn.status.is_ready_to_send &&
+	    ! conn.status.is_failed && ! conn.status.is_connecting)
+		m_NetProvider.flush(conn);
+}
+
 template<class BUFFER, class NetProvider>
 void
 Connector<BUFFER, NetProvider>::readyToDecode(Connection<BUFFER, NetProvider> &conn)
 {
-	//assert(rlist_empty(&m_ready_to_read));
+	if (conn.status.is_ready_to_decode)
+		return;
 	rlist_add_tail(&m_ready_to_read, &conn.m_in_read);
 	conn.status.is_ready_to_decode = true;
 }
@@ -0,0 +1,176 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * C++20 coroutine interface over Connector: a request flow is written as a
+ * plain function which suspends on co_await of a response and is resumed
+ * by Connector's wait methods right after the response is decoded:
+ *
+ * ClientTask flow(Connection<Buf_t, Net_t> &conn)
+ * {
+ *	Response<Buf_t> r =
+ *		co_await awaitResponse(conn, conn.space[512].select(key));
+ *	...
+ * }
+ * ...
+ * runUntil(client, [&]() { return task.done(); }, timeout);
+ *
+ * Awaiting does not allocate memory in steady state: the awaiter lives in
+ * the coroutine frame and registers itself as response handler.
+ */
+
+#if __cplusplus < 202002L || ! __has_include(<coroutine>)
+#error "Coroutine.hpp requires C++20 coroutines support"
+#endif
+
+#include "Connector.hpp"
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/**
+ * Coroutine which starts eagerly (in the caller) and runs till its first
+ * suspension. Task must not be destroyed while some other code may resume
+ * it; destroying a task suspended on response is safe: the response is
+ * going to be stored in the connection as if nobody waited for it.
+ */
+class ClientTask {
+public:
+	struct promise_type {
+		ClientTask get_return_object()
+		{
+			return ClientTask(Handle_t::from_promise(*this));
+		}
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		/* Keep the frame to let owner check completion. */
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		/* Connector is exception free, so are the request flows. */
+		void unhandled_exception() { std::terminate(); }
+	};
+	using Handle_t = std::coroutine_handle<promise_type>;
+
+	ClientTask(ClientTask &&other) noexcept :
+		m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+	ClientTask &operator=(ClientTask &&other) noexcept
+	{
+		std::swap(m_Handle, other.m_Handle);
+		return *this;
+	}
+	ClientTask(const ClientTask &) = delete;
+	ClientTask &operator=(const ClientTask &) = delete;
+	~ClientTask()
+	{
+		if (m_Handle)
+			m_Handle.destroy();
+	}
+	bool done() const { return ! m_Handle || m_Handle.done(); }
+private:
+	explicit ClientTask(Handle_t handle) : m_Handle(handle) {}
+	Handle_t m_Handle;
+};
+
+/**
+ * Awaiter of the response of @a future. If the response is already
+ * decoded, coroutine is not suspended at all.
+ */
+template<class BUFFER, class NetProvider>
+class ResponseAwaiter {
+public:
+	ResponseAwaiter(Connection<BUFFER, NetProvider> &conn, rid_t future) :
+		m_Conn(conn), m_Future(future), m_IsSuspended(false) {}
+	/* Handler refers to the awaiter, so it must stay in place. */
+	ResponseAwaiter(const ResponseAwaiter &) = delete;
+	ResponseAwaiter &operator=(const ResponseAwaiter &) = delete;
+	~ResponseAwaiter()
+	{
+		if (m_IsSuspended)
+			m_Conn.dropHandler(m_Future);
+	}
+
+	bool await_ready() { return m_Conn.futureIsReady(m_Future); }
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		m_Handle = handle;
+		m_IsSuspended = true;
+		m_Conn.onResponse(m_Future, [this](Response<BUFFER> &response) {
+			m_Response.emplace(std::move(response));
+			m_IsSuspended = false;
+			m_Handle.resume();
+		});
+	}
+	Response<BUFFER> await_resume()
+	{
+		if (m_Response.has_value())
+			return std::move(*m_Response);
+		std::optional<Response<BUFFER>> response =
+			m_Conn.getResponse(m_Future);
+		assert(response.has_value());
+		return std::move(*response);
+	}
+private:
+	Connection<BUFFER, NetProvider> &m_Conn;
+	rid_t m_Future;
+	bool m_IsSuspended;
+	std::coroutine_handle<> m_Handle;
+	std::optional<Response<BUFFER>> m_Response;
+};
+
+/** co_await awaitResponse(conn, conn.ping()) yields Response<BUFFER>. */
+template<class BUFFER, class NetProvider>
+ResponseAwaiter<BUFFER, NetProvider>
+awaitResponse(Connection<BUFFER, NetProvider> &conn, rid_t future)
+{
+	return ResponseAwaiter<BUFFER, NetProvider>(conn, future);
+}
+
+/**
+ * Run connector's event loop (resuming coroutines whose responses are
+ * decoded) until @a done() returns true. Return 0 on success and -1 if
+ * @a timeout (in milliseconds, 0 - infinite) has expired.
+ */
+template<class BUFFER, class NetProvider, class DONE>
+int
+runUntil(Connector<BUFFER, NetProvider> &client, DONE &&done, int timeout = 0)
+{
+	Timer timer{timeout};
+	timer.start();
+	while (! done()) {
+		if (timer.isExpired())
+			return -1;
+		client.waitAny(timeout - timer.elapsed());
+	}
+	return 0;
+}
@@ -58,35 +58,81 @@ public:
 	~DefaultNetProvider();
 	int connect(Conn_t &conn, const std::string_view& addr, unsigned port,
 		    size_t timeout);
+	/**
+	 * Start connecting without blocking: TCP handshake and greeting
+	 * are processed by wait(). Requests queued meanwhile are sent as
+	 * soon as the greeting is received. Connection which is not
+	 * established in @a timeout seconds fails.
+	 */
+	int connectAsync(Conn_t &conn, const std::string_view& addr,
+			 unsigned port, size_t timeout);
 	void close(Conn_t &conn);
 	/** Add to @m_ready_to_write*/
 	void readyToSend(Conn_t &conn);
+	/** Send queued data of connection without polling. */
+	void flush(Conn_t &conn);
 	/** Read and write to sockets; polling using epoll. */
 	int wait(int timeout);
 
 	bool check(Conn_t &conn);
+	/**
+	 * Set bounds of adaptive space reserved in input buffer of
+	 * connections established after the call.
+	 */
+	void setRecvReserve(size_t min_size, size_t max_size);
+	/**
+	 * Switch epoll to edge-triggered mode: sockets are registered
+	 * for both EPOLLIN and EPOLLOUT once and are never re-armed,
+	 * reads and writes are drained until EAGAIN instead. Must be
+	 * set before the first connection is established.
+	 */
+	void setEdgeTriggered(bool enable);
 private:
 	static constexpr size_t DEFAULT_TIMEOUT = 100;
-	static constexpr size_t EVENT_POLL_COUNT_MAX = 64;
 	static constexpr size_t EPOLL_QUEUE_LEN = 1024;
 	static constexpr size_t EPOLL_EVENTS_MAX = 128;
 
+	struct ConnectionState {
+		Conn_t *conn;
+		RecvReserve reserve;
+		/** Deadline of asynchronous connect. */
+		std::chrono::steady_clock::time_point connect_deadline;
+		/** TCP handshake of asynchronous connect is completed. */
+		bool is_connected;
+	};
+
 	void send(Conn_t &conn);
-	int recv(Conn_t &conn);
+	int recv(ConnectionState &state);
+	/** Advance asynchronous connect on socket @a events. */
+	void handshake(ConnectionState &state, uint32_t events);
+	/** Fail connects which are timed out; return time left to wait. */
+	int expireConnects(int timeout);
 
 	int poll(struct ConnectionEvent *fds, size_t *fd_count,
 		 int timeout = DEFAULT_TIMEOUT);
 	int setPollSetting(int socket, int setting);
-	int registerEpoll(int socket);
+	int registerEpoll(int socket, bool is_connecting = false);
 
 	/** <socket : connection> map. Contains both ready to read/send connections */
-	std::unordered_map<int, Conn_t *> m_Connections;
+	std::unordered_map<int, ConnectionState> m_Connections;
+	/** Template of receive reservation for new connections. */
+	RecvReserve m_RecvReserve;
 	rlist m_ready_to_write;
 	int m_EpollFd;
+	bool m_IsEdgeTriggered;
+	/** Count of connections with asynchronous connect in progress. */
+	size_t m_Connecting;
+	/**
+	 * Event arrays are kept per provider (not in function-local
+	 * statics), so that providers can live in different threads.
+	 */
+	struct epoll_event m_EpollEvents[EPOLL_EVENTS_MAX];
+	struct ConnectionEvent m_Events[EPOLL_EVENTS_MAX];
 };
 
 template<class BUFFER, class NETWORK>
-DefaultNetProvider<BUFFER, NETWORK>::DefaultNetProvider()
+DefaultNetProvider<BUFFER, NETWORK>::DefaultNetProvider() :
+	m_IsEdgeTriggered(false), m_Connecting(0)
 {
 	m_EpollFd = epoll_create(EPOLL_QUEUE_LEN);
 	if (m_EpollFd == -1) {
@@ -106,12 +152,16 @@ DefaultNetProvider<BUFFER, NETWORK>::~DefaultNetProvider()
 
 template<class BUFFER, class NETWORK>
 int
-DefaultNetProvider<BUFFER, NETWORK>::registerEpoll(int socket)
+DefaultNetProvider<BUFFER, NETWORK>::registerEpoll(int socket,
+						   bool is_connecting)
 {
 	/* Configure epoll with new socket. */
 	assert(m_EpollFd >= 0);
 	struct epoll_event event;
-	event.events = EPOLLIN;
+	event.events = m_IsEdgeTriggered ? EPOLLIN | EPOLLOUT | EPOLLET : EPOLLIN;
+	/* Connect is completed once socket becomes writable. */
+	if (is_connecting)
+		event.events |= EPOLLOUT;
 	event.data.fd = socket;
 	if (epoll_ctl(m_EpollFd, EPOLL_CTL_ADD, socket, &event) != 0)
 		return -1;
@@ -166,18 +216,131 @@ DefaultNetProvider<BUFFER, NETWORK>::connect(Conn_t &conn,
 		return -1;
 	}
 	LOG_DEBUG("Greetings are decoded");
-	LOG_DEBUG("Authentication processing...");
-	//TODO: add authentication step.
+	/* AUTH request (if any) is queued by decodeGreeting(). */
 	if (registerEpoll(socket) != 0) {
 		conn.setError(std::string("Failed to register epoll watcher"));
 		::close(socket);
 		return -1;
 	}
 	conn.socket = socket;
-	m_Connections[socket] = &conn;
+	m_Connections.insert({socket, ConnectionState{&conn, m_RecvReserve,
+						      {}, true}});
 	return 0;
 }
 
+template<class BUFFER, class NETWORK>
+int
+DefaultNetProvider<BUFFER, NETWORK>::connectAsync(Conn_t &conn,
+						  const std::string_view& addr,
+						  unsigned port, size_t timeout)
+{
+	int socket = port == 0 ? NETWORK::connectUNIX(addr) :
+				 NETWORK::connectINETAsync(addr, port);
+	if (socket < 0) {
+		conn.setError(std::string("Failed to establish connection to ") +
+			      std::string(addr));
+		return -1;
+	}
+	if (registerEpoll(socket, true) != 0) {
+		conn.setError(std::string("Failed to register epoll watcher"));
+		::close(socket);
+		return -1;
+	}
+	LOG_DEBUG("Connecting to ", addr, ", socket is ", socket);
+	conn.socket = socket;
+	conn.status.is_connecting = true;
+	m_Connecting++;
+	auto deadline = std::chrono::steady_clock::now() +
+			std::chrono::seconds(timeout);
+	m_Connections.insert({socket, ConnectionState{&conn, m_RecvReserve,
+						      deadline, false}});
+	return 0;
+}
+
+template<class BUFFER, class NETWORK>
+void
+DefaultNetProvider<BUFFER, NETWORK>::handshake(ConnectionState &state,
+					       uint32_t events)
+{
+	Conn_t &conn = *state.conn;
+	if (! state.is_connected) {
+		/* Failed connect is reported with EPOLLERR. */
+		if ((events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) == 0)
+			return;
+		int err = NETWORK::socketError(conn.socket);
+		if (err != 0) {
+			conn.setError(std::string("Failed to establish "
+						  "connection: ") + strerror(err));
+			close(conn);
+			return;
+		}
+		LOG_DEBUG("Connection to socket ", conn.socket, " is established");
+		state.is_connected = true;
+		if (! m_IsEdgeTriggered && setPollSetting(conn.socket, EPOLLIN) != 0) {
+			conn.setError(std::string("Failed to change epoll mode: ") +
+				      strerror(errno));
+			close(conn);
+			return;
+		}
+	}
+	/* Greeting is read right into the input buffer. */
+	size_t left;
+	while ((left = greetingBytesLeft(conn)) > 0) {
+		size_t iov_cnt = 0;
+		struct iovec *iov = inBufferToIOV(conn, left, &iov_cnt);
+		int read_bytes = NETWORK::recv(conn.socket, iov, iov_cnt);
+		int saved_errno = errno;
+		hasNotRecvBytes(conn, left - (read_bytes > 0 ? read_bytes : 0));
+		if (read_bytes < 0 && netWouldBlock(saved_errno))
+			return;
+		if (read_bytes <= 0) {
+			conn.setError(read_bytes == 0 ?
+				std::string("Connection is closed by peer") :
+				std::string("Failed to receive greetings: ") +
+				strerror(saved_errno));
+			close(conn);
+			return;
+		}
+	}
+	if (decodeGreeting(conn) != 0) {
+		conn.setError(std::string("Failed to decode greetings"));
+		close(conn);
+		return;
+	}
+	LOG_DEBUG("Greetings are decoded");
+	conn.status.is_connecting = false;
+	m_Connecting--;
+	/* Send requests queued during connect without extra wakeup. */
+	if (conn.status.is_ready_to_send)
+		send(conn);
+}
+
+template<class BUFFER, class NETWORK>
+int
+DefaultNetProvider<BUFFER, NETWORK>::expireConnects(int timeout)
+{
+	auto now = std::chrono::steady_clock::now();
+	auto next = std::chrono::steady_clock::time_point::max();
+	std::vector<Conn_t *> expired;
+	for (auto &c : m_Connections) {
+		if (! c.second.conn->status.is_connecting)
+			continue;
+		if (c.second.connect_deadline <= now)
+			expired.push_back(c.second.conn);
+		else
+			next = std::min(next, c.second.connect_deadline);
+	}
+	for (Conn_t *conn : expired) {
+		conn->setError("Connect is timed out");
+		close(*conn);
+	}
+	if (m_Connecting == 0)
+		return timeout;
+	using namespace std::chrono;
+	int left = (int) ceil<milliseconds>(next - now).count();
+	return std::min(timeout, std::max(left, 1));
+}
+
 template<class BUFFER, class NETWORK>
 void
 DefaultNetProvider<BUFFER, NETWORK>::close(Conn_t &connection)
@@ -214,6 +377,10 @@ DefaultNetProvider<BUFFER, NETWORK>::close(Conn_t &connection)
 	}
 	m_Connections.erase(connection.socket);
 	connection.socket = -1;
+	if (connection.status.is_connecting) {
+		connection.status.is_connecting = false;
+		m_Connecting--;
+	}
 }
 
 template<class BUFFER, class NETWORK>
@@ -221,12 +388,12 @@ int
 DefaultNetProvider<BUFFER, NETWORK>::poll(struct ConnectionEvent *fds,
 					  size_t *fd_count, int timeout)
 {
-	static struct epoll_event events[EPOLL_EVENTS_MAX];
+	struct epoll_event *events = m_EpollEvents;
 	*fd_count = 0;
 	int event_cnt = epoll_wait(m_EpollFd, events, EPOLL_EVENTS_MAX,
 				   timeout);
 	if (event_cnt == -1)
-		return -1;
+		return errno == EINTR ? 0 : -1;
 	assert(event_cnt >= 0);
 	for (int i = 0; i < event_cnt; ++i) {
 		fds[*fd_count].sock = events[i].data.fd;
@@ -241,62 +408,66 @@ template<class BUFFER, class NETWORK>
 void
 DefaultNetProvider<BUFFER, NETWORK>::readyToSend(Conn_t &conn)
 {
-	if (conn.status.is_send_blocked) {
-#ifndef NDEBUG
-		// If connection's send is blocked, then it must be in
-		// the write list anyway.
-		Connection<BUFFER, DefaultNetProvider> *tmp;
-		rlist_foreach_entry(tmp, &m_ready_to_write, m_in_write) {
-			if (tmp->socket == conn.socket)
-				return;
-		}
-		assert(0);
-#endif
+	/*
+	 * Connection stays in the write list (and so keeps the flag) until
+	 * all its data is sent. Blocked connection is in the list as well.
+	 */
+	if (conn.status.is_ready_to_send) {
+		assert(! rlist_empty(&conn.m_in_write));
 		return;
 	}
-
-	Connection<BUFFER, DefaultNetProvider> *tmp;
-	rlist_foreach_entry(tmp, &m_ready_to_write, m_in_write) {
-		if (tmp == &conn)
-			return;
-	}
+	assert(! conn.status.is_send_blocked);
 	rlist_add_tail(&m_ready_to_write, &conn.m_in_write);
 	conn.status.is_ready_to_send = true;
 }
 
+template<class BUFFER, class NETWORK>
+void
+DefaultNetProvider<BUFFER, NETWORK>::flush(Conn_t &conn)
+{
+	/* Blocked socket is flushed as soon as it becomes writable. */
+	if (conn.status.is_send_blocked || conn.status.is_connecting)
+		return;
+	send(conn);
+}
+
 template<class BUFFER, class NETWORK>
 int
-DefaultNetProvider<BUFFER, NETWORK>::recv(Conn_t &conn)
+DefaultNetProvider<BUFFER, NETWORK>::recv(ConnectionState &state)
 {
+	Conn_t &conn = *state.conn;
 	assert(! conn.status.is_failed);
-	size_t total = NETWORK::readyToRecv(conn.socket);
-	if (total < 0) {
-		LOG_ERROR("Failed to check socket: ioctl returned errno ",
-			  strerror(errno));
-		return -1;
-	}
-	if (total == 0) {
-		LOG_DEBUG("Socket ", conn.socket, " has no data to read");
-		return -1;
-	}
+	/*
+	 * Reserve space in advance and read with a single recvmsg():
+	 * there's no need to ask socket how much data it has.
+	 */
+	size_t reserved = std::min(state.reserve.size,
+				   BUFFER::blockSize() * Conn_t::MAX_IOVEC_COUNT);
 	size_t iov_cnt = 0;
-	struct iovec *iov =
-		inBufferToIOV(conn, total, &iov_cnt);
+	struct iovec *iov = inBufferToIOV(conn, reserved, &iov_cnt);
+	size_t capacity = IOVCountBytes(iov, iov_cnt);
 	int read_bytes = NETWORK::recvall(conn.socket, iov, iov_cnt, true);
-	hasNotRecvBytes(conn, total - read_bytes);
+	int saved_errno = errno;
+	statRecvCall(conn, read_bytes);
+	hasNotRecvBytes(conn, reserved - (read_bytes > 0 ? read_bytes : 0));
 	LOG_DEBUG("read ", read_bytes, " bytes from ", conn.socket, " socket");
 	if (read_bytes < 0) {
-		if (errno == EWOULDBLOCK || errno == EAGAIN)
+		if (netWouldBlock(saved_errno))
 			return -1;
 		conn.setError(std::string("Failed to receive response: ") +
-					  strerror(errno));
-		if (errno == EBADF || errno == ENOTCONN ||
-		    errno == ENOTSOCK || errno == EINVAL) {
-				close(conn);
-		}
+					  strerror(saved_errno));
+		/* Otherwise failed socket keeps reporting events. */
+		close(conn);
 		return -1;
 	}
-	return total - read_bytes;
+	if (read_bytes == 0) {
+		conn.setError("Connection is closed by peer");
+		close(conn);
+		return -1;
+	}
+	state.reserve.update(read_bytes, capacity);
+	/* Short read means that socket has been drained. */
+	return (size_t) read_bytes < capacity ? 0 : 1;
 }
 
 template<class BUFFER, class NETWORK>
@@ -305,37 +476,39 @@ DefaultNetProvider<BUFFER, NETWORK>::send(Conn_t &conn)
 {
 	assert(! conn.status.is_failed);
 	while (hasDataToSend(conn)) {
-		size_t sent_bytes = 0;
 		size_t iov_cnt = 0;
 		struct iovec *iov = outBufferToIOV(conn, &iov_cnt);
-		int rc = NETWORK::sendall(conn.socket, iov, iov_cnt,
-						 &sent_bytes);
-		hasSentBytes(conn, sent_bytes);
-		LOG_DEBUG("send ", sent_bytes, " bytes to the ", conn.socket, " socket");
-		if (rc != 0) {
-			if (errno == EWOULDBLOCK || errno == EAGAIN) {
-				int setting = EPOLLIN | EPOLLOUT;
-				if (setPollSetting(conn.socket, setting) != 0) {
-					LOG_ERROR("Failed to change epoll mode: "
-						  "epoll_ctl() returned with errno: ",
-						  strerror(errno));
-					abort();
-				}
-				conn.status.is_send_blocked = true;
-			} else {
-				conn.setError(std::string("Failed to send request: ") +
-					      strerror(errno));
-				if (errno == EBADF || errno == ENOTSOCK ||
-				    errno == EFAULT || errno == EINVAL ||
-				    errno == EPIPE) {
-					close(conn);
-				}
+		/* One syscall per iteration: short write is retried. */
+		int rc = NETWORK::send(conn.socket, iov, iov_cnt);
+		statSendCall(conn, iov, iov_cnt, rc);
+		if (rc >= 0) {
+			hasSentBytes(conn, rc);
+			LOG_DEBUG("send ", rc, " bytes to the ", conn.socket, " socket");
+			continue;
+		}
+		if (errno == EWOULDBLOCK || errno == EAGAIN) {
+			conn.status.is_send_blocked = true;
+			/* Edge-triggered socket is always watched for EPOLLOUT. */
+			if (m_IsEdgeTriggered)
+				return;
+			int setting = EPOLLIN | EPOLLOUT;
+			if (setPollSetting(conn.socket, setting) != 0) {
+				LOG_ERROR("Failed to change epoll mode: "
+					  "epoll_ctl() returned with errno: ",
+					  strerror(errno));
+				abort();
 			}
-			return;
+		} else {
+			conn.setError(std::string("Failed to send request: ") +
+				      strerror(errno));
+			close(conn);
 		}
+		return;
 	}
 	/* All data from connection has been successfully written. */
-	if (conn.status.is_send_blocked) {
+	if (conn.status.is_send_blocked && m_IsEdgeTriggered) {
+		conn.status.is_send_blocked = false;
+	} else if (conn.status.is_send_blocked) {
 		if (setPollSetting(conn.socket, EPOLLIN) != 0) {
 			LOG_ERROR("Failed to change epoll mode: epoll_ctl() "
 				  "returned with errno: ", strerror(errno));
@@ -354,39 +527,97 @@ DefaultNetProvider<BUFFER, NETWORK>::wait(int timeout)
 		timeout = DEFAULT_TIMEOUT;
 	LOG_DEBUG("Network engine wait for ", timeout, " milliseconds");
 	/* Send pending requests. */
+	bool has_failed = false;
 	if (!rlist_empty(&m_ready_to_write)) {
 		Connection<BUFFER, DefaultNetProvider> *conn, *tmp;
 		rlist_foreach_entry_safe(conn, &m_ready_to_write, m_in_write, tmp) {
+			/*
+			 * Blocked edge-triggered socket is going to be
+			 * flushed on EPOLLOUT event.
+			 */
+			if (m_IsEdgeTriggered && conn->status.is_send_blocked)
+				continue;
+			/* Requests are sent once greeting is received. */
+			if (conn->status.is_connecting || conn->status.is_failed)
+				continue;
 			send(*conn);
+			has_failed = has_failed || conn->status.is_failed;
 		}
 	}
+	/* Report failed connection without sleeping in poll. */
+	if (has_failed)
+		timeout = 0;
+	if (m_Connecting != 0)
+		timeout = expireConnects(timeout);
 	/* Firstly poll connections to point out if there's data to read. */
-	static struct ConnectionEvent events[EVENT_POLL_COUNT_MAX];
+	struct ConnectionEvent *events = m_Events;
 	size_t event_cnt = 0;
-	if (poll((ConnectionEvent *)&events, &event_cnt, timeout) != 0) {
+	if (poll(events, &event_cnt, timeout) != 0) {
 		LOG_ERROR("Poll failed: ", strerror(errno));
 		return -1;
 	}
 	for (size_t i = 0; i < event_cnt; ++i) {
-		Connection<BUFFER, DefaultNetProvider> *conn =
-			m_Connections[events[i].sock];
+		auto state = m_Connections.find(events[i].sock);
+		if (state == m_Connections.end())
+			continue;
+		Connection<BUFFER, DefaultNetProvider> *conn = state->second.conn;
+		/* Failed connection is closed or about to be restored. */
+		if (conn->status.is_failed)
+			continue;
+		if (conn->status.is_connecting) {
+			handshake(state->second, events[i].event);
+			continue;
+		}
 		if ((events[i].event & EPOLLIN) != 0) {
 			LOG_DEBUG("Registered poll event ", i, ": ",
 				  conn->socket, " socket is ready to read");
-			if (recv(*conn) == 0)
+			int rc = recv(state->second);
+			/* Edge is reported once: read until socket is drained. */
+			bool has_data = rc >= 0;
+			while (rc > 0 && m_IsEdgeTriggered) {
+				rc = recv(state->second);
+				has_data = has_data || rc >= 0;
+			}
+			if (has_data)
 				conn->readyToDecode();
+			if (conn->status.is_failed)
+				continue;
 		}
 		if ((events[i].event & EPOLLOUT) != 0) {
-			/* We are watching only for blocked sockets. */
 			LOG_DEBUG("Registered poll event ", i, ": ",
 				  conn->socket, " socket is ready to write");
-			assert(conn->status.is_send_blocked);
-			send(*conn);
+			/*
+			 * Level-triggered sockets are watched only while
+			 * blocked; edge-triggered ones report every time
+			 * send buffer space is freed.
+			 */
+			assert(conn->status.is_send_blocked || m_IsEdgeTriggered);
+			if (conn->status.is_send_blocked)
+				send(*conn);
 		}
 	}
+	if (m_Connecting != 0)
+		expireConnects(0);
 	return 0;
 }
 
+template<class BUFFER, class NETWORK>
+void
+DefaultNetProvider<BUFFER, NETWORK>::setRecvReserve(size_t min_size,
+						    size_t max_size)
+{
+	assert(min_size > 0 && min_size <= max_size);
+	m_RecvReserve = RecvReserve(min_size, max_size);
+}
+
+template<class BUFFER, class NETWORK>
+void
+DefaultNetProvider<BUFFER, NETWORK>::setEdgeTriggered(bool enable)
+{
+	assert(m_Connections.empty());
+	m_IsEdgeTriggered = enable;
+}
+
 template<class BUFFER, class NETWORK>
 bool
 DefaultNetProvider<BUFFER, NETWORK>::check(Conn_t &connection)
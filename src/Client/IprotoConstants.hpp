@@ -60,6 +60,7 @@ namespace Iproto {
 		GROUP_ID = 0x07,
 		TSN = 0x08,
 		FLAGS = 0x09,
+		STREAM_ID = 0x0a,
 		SPACE_ID = 0x10,
 		INDEX_ID = 0x11,
 		LIMIT = 0x12,
@@ -90,6 +91,8 @@ namespace Iproto {
 		REPLICA_ANON = 0x50,
 		ID_FILTER = 0x51,
 		ERROR = 0x52,
+		TIMEOUT = 0x56,
+		TXN_ISOLATION = 0x59,
 		KEY_MAX
 	};
 
@@ -102,6 +105,11 @@ namespace Iproto {
 		FIELD_SPAN = 5,
 	};
 
+	enum SqlInfoKey {
+		SQL_INFO_ROW_COUNT = 0,
+		SQL_INFO_AUTOINCREMENT_IDS = 1,
+	};
+
 	enum Type {
 		OK = 0,
 		SELECT = 1,
@@ -117,10 +125,16 @@ namespace Iproto {
 		EXECUTE = 11,
 		NOP = 12,
 		PREPARE = 13,
+		TXN_BEGIN = 14,
+		TXN_COMMIT = 15,
+		TXN_ROLLBACK = 16,
 		TYPE_STAT_MAX,
 		RAFT = 30,
 		CONFIRM = 40,
 		ROLLBACK = 41,
+		/* Names of synchronous replication types used by Tarantool. */
+		RAFT_CONFIRM = CONFIRM,
+		RAFT_ROLLBACK = ROLLBACK,
 		PING = 64,
 		JOIN = 65,
 		SUBSCRIBE = 66,
@@ -135,6 +149,14 @@ namespace Iproto {
 		TYPE_ERROR = 1 << 15
 	};
 
+	/** Isolation level of transaction started by BEGIN. */
+	enum TxnIsolation {
+		TXN_ISOLATION_DEFAULT = 0,
+		TXN_ISOLATION_READ_COMMITTED = 1,
+		TXN_ISOLATION_READ_CONFIRMED = 2,
+		TXN_ISOLATION_BEST_EFFORT = 3,
+	};
+
 	enum ErrorStack {
 		ERROR_STACK = 0x00
 	};
@@ -149,4 +171,10 @@ namespace Iproto {
 		ERROR_FIELDS = 0x06,
 		ERROR_MAX,
 	};
+
+	/** Error codes which are also reported by connector itself. */
+	enum ErrorCode {
+		ER_NO_CONNECTION = 77,
+		ER_TIMEOUT = 78,
+	};
 }
@@ -51,8 +51,13 @@ struct WaitWatcher {
 	struct ev_io in;
 	struct ev_io out;
 	struct ev_timer *timer;
+	/** Deadline of asynchronous connect. */
+	struct ev_timer connect_timer;
+	/** TCP handshake of asynchronous connect is completed. */
+	bool is_connected;
 	void *connection;
 	void *provider;
+	RecvReserve reserve;
 };
 
 static inline void
@@ -71,8 +76,17 @@ public:
 	LibevNetProvider(struct ev_loop *loop = nullptr);
 	int connect(Conn_t &conn, const std::string_view& addr, unsigned port,
 		    size_t timeout);
+	/**
+	 * Start connecting without blocking: TCP handshake and greeting
+	 * are processed by the loop. Requests queued meanwhile are sent
+	 * as soon as the greeting is received.
+	 */
+	int connectAsync(Conn_t &conn, const std::string_view& addr,
+			 unsigned port, size_t timeout);
 	void close(Conn_t &conn);
 	void readyToSend(Conn_t &conn);
+	/** Send queued data of connection without running the loop. */
+	void flush(Conn_t &conn);
 	int wait(int timeout);
 	bool check(Conn_t &conn);
 
@@ -101,35 +115,41 @@ LibevNetProvider<BUFFER, NETWORK>::releaseWatchers(int fd)
 	struct WaitWatcher *watcher = m_Watchers[fd];
 	ev_io_stop(m_Loop, &watcher->in);
 	ev_io_stop(m_Loop, &watcher->out);
+	ev_timer_stop(m_Loop, &watcher->connect_timer);
 	free(watcher);
 	m_Watchers.erase(fd);
 }
 
 template<class BUFFER, class NETWORK>
 static inline int
-connectionReceive(Connection<BUFFER,  LibevNetProvider<BUFFER, NETWORK>> &conn)
+connectionReceive(Connection<BUFFER,  LibevNetProvider<BUFFER, NETWORK>> &conn,
+		  RecvReserve &reserve)
 {
+	using Conn_t = Connection<BUFFER, LibevNetProvider<BUFFER, NETWORK>>;
 	assert(! conn.status.is_failed);
-	size_t total = NETWORK::readyToRecv(conn.socket);
-	if (total < 0) {
-		LOG_ERROR("Failed to check socket: ioctl returned errno ",
-			  strerror(errno));
-		return -1;
-	}
+	size_t reserved = std::min(reserve.size,
+				   BUFFER::blockSize() * Conn_t::MAX_IOVEC_COUNT);
 	size_t iov_cnt = 0;
-	struct iovec *iov =
-		inBufferToIOV(conn, total, &iov_cnt);
+	struct iovec *iov = inBufferToIOV(conn, reserved, &iov_cnt);
+	size_t capacity = IOVCountBytes(iov, iov_cnt);
 	int read_bytes = NETWORK::recvall(conn.socket, iov, iov_cnt, true);
-	hasNotRecvBytes(conn, total - read_bytes);
+	int saved_errno = errno;
+	statRecvCall(conn, read_bytes);
+	hasNotRecvBytes(conn, reserved - (read_bytes > 0 ? read_bytes : 0));
 	if (read_bytes < 0) {
-		if (netWouldBlock(errno)) {
+		if (netWouldBlock(saved_errno)) {
 			return 1;
 		}
 		conn.setError(std::string("Failed to receive response: ") +
-			       strerror(errno));
+			       strerror(saved_errno));
+		return -1;
+	}
+	if (read_bytes == 0) {
+		conn.setError("Connection is closed by peer");
 		return -1;
 	}
-	return total - read_bytes;
+	reserve.update(read_bytes, capacity);
+	return 0;
 }
 
 template<class BUFFER, class NETWORK>
@@ -145,7 +165,7 @@ recv_cb(struct ev_loop *loop, struct ev_io *watcher, int /* revents */)
 	assert(waitWatcher->in.fd == conn->socket);
 
 	timerDisable(loop, waitWatcher->timer);
-	int rc = connectionReceive(*conn);
+	int rc = connectionReceive(*conn, waitWatcher->reserve);
 	if (rc < 0) {
 		NetProvider_t *provider =
 			reinterpret_cast<NetProvider_t *>(waitWatcher->provider);
@@ -162,23 +182,25 @@ connectionSend(Connection<BUFFER,  LibevNetProvider<BUFFER, NETWORK>> &conn)
 {
 	assert(! conn.status.is_failed);
 	while (hasDataToSend(conn)) {
-		size_t sent_bytes = 0;
 		size_t iov_cnt = 0;
 		struct iovec *iov = outBufferToIOV(conn, &iov_cnt);
-		int rc = NETWORK::sendall(conn.socket, iov, iov_cnt,
-					  &sent_bytes);
-		hasSentBytes(conn, sent_bytes);
-		if (rc != 0) {
-			if (netWouldBlock(errno)) {
-				conn.status.is_send_blocked = true;
-				return 1;
-			}
-			conn.setError(std::string("Failed to send request: ") +
-				      strerror(errno));
-			return -1;
+		/* One syscall per iteration: short write is retried. */
+		int rc = NETWORK::send(conn.socket, iov, iov_cnt);
+		statSendCall(conn, iov, iov_cnt, rc);
+		if (rc >= 0) {
+			hasSentBytes(conn, rc);
+			continue;
+		}
+		if (netWouldBlock(errno)) {
+			conn.status.is_send_blocked = true;
+			return 1;
 		}
+		conn.setError(std::string("Failed to send request: ") +
+			      strerror(errno));
+		return -1;
 	}
 	/* All data from connection has been successfully written. */
+	conn.status.is_send_blocked = false;
 	return 0;
 }
 
@@ -194,6 +216,11 @@ send_cb(struct ev_loop *loop, struct ev_io *watcher, int /* revents */)
 		reinterpret_cast<Connection<BUFFER, NetProvider_t> *>(waitWatcher->connection);
 	assert(watcher->fd == conn->socket);
 	timerDisable(loop, waitWatcher->timer);
+	/* Data which is not queued yet (e.g. held by cork) stays in buffer. */
+	if (! conn->status.is_ready_to_send) {
+		ev_io_stop(loop, watcher);
+		return;
+	}
 	int rc = connectionSend(*conn);
 	if (rc < 0) {
 		NetProvider_t *provider =
@@ -217,12 +244,107 @@ send_cb(struct ev_loop *loop, struct ev_io *watcher, int /* revents */)
 		ev_io_stop(loop, watcher);
 }
 
+/**
+ * Advance asynchronous connect. Return 0 once the greeting is decoded,
+ * 1 if more events are expected and -1 on error.
+ */
+template<class BUFFER, class NETWORK>
+static inline int
+connectionHandshake(Connection<BUFFER,  LibevNetProvider<BUFFER, NETWORK>> &conn,
+		    WaitWatcher &waitWatcher)
+{
+	if (! waitWatcher.is_connected) {
+		int err = NETWORK::socketError(conn.socket);
+		if (err != 0) {
+			conn.setError(std::string("Failed to establish "
+						  "connection: ") + strerror(err));
+			return -1;
+		}
+		waitWatcher.is_connected = true;
+	}
+	/* Greeting is read right into the input buffer. */
+	size_t left;
+	while ((left = greetingBytesLeft(conn)) > 0) {
+		size_t iov_cnt = 0;
+		struct iovec *iov = inBufferToIOV(conn, left, &iov_cnt);
+		int read_bytes = NETWORK::recv(conn.socket, iov, iov_cnt);
+		int saved_errno = errno;
+		hasNotRecvBytes(conn, left - (read_bytes > 0 ? read_bytes : 0));
+		if (read_bytes < 0 && netWouldBlock(saved_errno))
+			return 1;
+		if (read_bytes <= 0) {
+			conn.setError(read_bytes == 0 ?
+				std::string("Connection is closed by peer") :
+				std::string("Failed to receive greetings: ") +
+				strerror(saved_errno));
+			return -1;
+		}
+	}
+	if (decodeGreeting(conn) != 0) {
+		conn.setError(std::string("Failed to decode greetings"));
+		return -1;
+	}
+	return 0;
+}
+
+template<class BUFFER, class NETWORK>
+static void
+handshake_cb(struct ev_loop *loop, struct ev_io *watcher, int /* revents */)
+{
+	using NetProvider_t = LibevNetProvider<BUFFER, NETWORK>;
+	struct WaitWatcher *waitWatcher =
+		reinterpret_cast<struct WaitWatcher *>(watcher->data);
+	Connection<BUFFER, NetProvider_t> *conn =
+		reinterpret_cast<Connection<BUFFER, NetProvider_t> *>(waitWatcher->connection);
+	NetProvider_t *provider =
+		reinterpret_cast<NetProvider_t *>(waitWatcher->provider);
+	timerDisable(loop, waitWatcher->timer);
+	int rc = connectionHandshake(*conn, *waitWatcher);
+	if (rc < 0) {
+		provider->close(*conn);
+		return;
+	}
+	/* Socket stays writable: wait for the greeting only. */
+	if (waitWatcher->is_connected && ev_is_active(&waitWatcher->out))
+		ev_io_stop(loop, &waitWatcher->out);
+	if (rc > 0)
+		return;
+	LOG_DEBUG("Greetings are decoded");
+	ev_timer_stop(loop, &waitWatcher->connect_timer);
+	ev_set_cb(&waitWatcher->in, (&recv_cb<BUFFER, NETWORK>));
+	ev_set_cb(&waitWatcher->out, (&send_cb<BUFFER, NETWORK>));
+	conn->status.is_connecting = false;
+	/* Send requests queued during connect without extra wakeup. */
+	if (conn->status.is_ready_to_send)
+		send_cb<BUFFER, NETWORK>(loop, &waitWatcher->out, EV_WRITE);
+}
+
+template<class BUFFER, class NETWORK>
+static void
+connect_timeout_cb(struct ev_loop * /* loop */, struct ev_timer *timer,
+		   int /* revents */)
+{
+	using NetProvider_t = LibevNetProvider<BUFFER, NETWORK>;
+	struct WaitWatcher *waitWatcher =
+		reinterpret_cast<struct WaitWatcher *>(timer->data);
+	Connection<BUFFER, NetProvider_t> *conn =
+		reinterpret_cast<Connection<BUFFER, NetProvider_t> *>(waitWatcher->connection);
+	NetProvider_t *provider =
+		reinterpret_cast<NetProvider_t *>(waitWatcher->provider);
+	conn->setError("Connect is timed out");
+	provider->close(*conn);
+}
+
 template<class BUFFER, class NETWORK>
 LibevNetProvider<BUFFER, NETWORK>::LibevNetProvider(struct ev_loop *loop) :
 	m_Loop(loop), m_IsOwnLoop(false)
 {
 	if (m_Loop == nullptr) {
-		m_Loop = ev_default_loop(0);
+		/*
+		 * Default loop is shared by all its users, so it can't be
+		 * destroyed by provider. Create a private loop instead.
+		 */
+		m_Loop = ev_loop_new(EVFLAG_AUTO);
 		m_IsOwnLoop = true;
 	}
 	assert(m_Loop != nullptr);
@@ -257,6 +379,7 @@ LibevNetProvider<BUFFER, NETWORK>::registerWatchers(Conn_t *conn, int fd)
 	watcher->timer = &m_TimeoutWatcher;
 	watcher->connection = conn;
 	watcher->provider = this;
+	watcher->reserve = RecvReserve();
 	ev_io_init(&watcher->in, (&recv_cb<BUFFER, NETWORK>), fd, EV_READ);
 	ev_io_init(&watcher->out, (&send_cb<BUFFER, NETWORK>), fd, EV_WRITE);
 
@@ -310,6 +433,38 @@ LibevNetProvider<BUFFER, NETWORK>::connect(Conn_t &conn,
 	return 0;
 }
 
+template<class BUFFER, class NETWORK>
+int
+LibevNetProvider<BUFFER, NETWORK>::connectAsync(Conn_t &conn,
+						const std::string_view& addr,
+						unsigned port, size_t timeout)
+{
+	int socket = port == 0 ? NETWORK::connectUNIX(addr) :
+				 NETWORK::connectINETAsync(addr, port);
+	if (socket < 0) {
+		conn.setError(std::string("Failed to establish connection to ") +
+			      std::string(addr));
+		return -1;
+	}
+	if (registerWatchers(&conn, socket) != 0) {
+		conn.setError(std::string("Failed to register libev watchers"));
+		::close(socket);
+		return -1;
+	}
+	LOG_DEBUG("Connecting to ", addr, ", socket is ", socket);
+	conn.socket = socket;
+	conn.status.is_connecting = true;
+	/* Both watchers are already started: connect completes on write. */
+	WaitWatcher *watcher = m_Watchers[socket];
+	ev_set_cb(&watcher->in, (&handshake_cb<BUFFER, NETWORK>));
+	ev_set_cb(&watcher->out, (&handshake_cb<BUFFER, NETWORK>));
+	ev_timer_init(&watcher->connect_timer,
+		      (&connect_timeout_cb<BUFFER, NETWORK>), timeout, 0);
+	watcher->connect_timer.data = watcher;
+	ev_timer_start(m_Loop, &watcher->connect_timer);
+	return 0;
+}
+
 template<class BUFFER, class NETWORK>
 void
 LibevNetProvider<BUFFER, NETWORK>::close(Conn_t &conn)
@@ -319,24 +474,39 @@ LibevNetProvider<BUFFER, NETWORK>::close(Conn_t &conn)
 		releaseWatchers(conn.socket);
 	}
 	conn.socket = -1;
+	conn.status.is_connecting = false;
 }
 
 template<class BUFFER, class NETWORK>
 void
 LibevNetProvider<BUFFER, NETWORK>::readyToSend(Conn_t &conn)
 {
-	if (conn.status.is_send_blocked)
-		return;
-	Connection<BUFFER, LibevNetProvider> *tmp;
 	/* Check if connection is already queued to be send. */
-	rlist_foreach_entry(tmp, &m_ready_to_write, m_in_write) {
-		if (tmp == &conn)
-			return;
+	if (conn.status.is_ready_to_send) {
+		assert(! rlist_empty(&conn.m_in_write));
+		return;
 	}
 	rlist_add_tail(&m_ready_to_write, &conn.m_in_write);
 	conn.status.is_ready_to_send = true;
 }
 
+template<class BUFFER, class NETWORK>
+void
+LibevNetProvider<BUFFER, NETWORK>::flush(Conn_t &conn)
+{
+	auto w = m_Watchers.find(conn.socket);
+	if (w == m_Watchers.end() || ev_is_active(&w->second->out) ||
+	    conn.status.is_connecting)
+		return;
+	int rc = connectionSend(conn);
+	if (rc < 0) {
+		close(conn);
+		return;
+	}
+	if (rc > 0)
+		ev_io_start(m_Loop, &w->second->out);
+}
+
 static void
 timeout_cb(EV_P_ ev_timer *w, int /* revents */)
 {
@@ -357,6 +527,9 @@ LibevNetProvider<BUFFER, NETWORK>::wait(int timeout)
 	if (! rlist_empty(&m_ready_to_write)) {
 		Connection<BUFFER, LibevNetProvider> *conn;
 		rlist_foreach_entry(conn, &m_ready_to_write, m_in_write) {
+			/* Requests are sent once greeting is received. */
+			if (conn->status.is_connecting)
+				continue;
 			auto w = m_Watchers.find(conn->socket);
 			assert(w != m_Watchers.end());
 			if (! ev_is_active(&w->second->out))
@@ -31,6 +31,7 @@
  */
 #include <assert.h>
 #include <errno.h>
+#include <algorithm>
 #include <unistd.h>
 #include <stdexcept>
 #include <cstring>
@@ -81,10 +82,63 @@ netWouldBlock(int err)
 	return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
 }
 
+/**
+ * Adaptive amount of space reserved in the tail of input buffer before
+ * reading from socket. Data is read with a single recvmsg() and unused
+ * part of reservation is trimmed afterwards. The reservation doubles each
+ * time a read fills it completely and halves after a series of reads which
+ * occupy less than a quarter of it.
+ */
+struct RecvReserve {
+	static constexpr size_t DEFAULT_MIN_SIZE = 1024;
+	static constexpr size_t DEFAULT_MAX_SIZE = 1024 * 1024;
+	static constexpr size_t DEFAULT_SIZE = 16 * 1024;
+	static constexpr unsigned SHRINK_STREAK = 8;
+
+	RecvReserve(size_t min = DEFAULT_MIN_SIZE, size_t max = DEFAULT_MAX_SIZE) :
+		min_size(min), max_size(max),
+		size(std::clamp(DEFAULT_SIZE, min, max)), small_reads(0) {}
+	/**
+	 * Adjust reservation according to the last read: @a read_bytes out
+	 * of @a capacity bytes which were available to the read.
+	 */
+	void update(size_t read_bytes, size_t capacity)
+	{
+		if (read_bytes >= capacity) {
+			small_reads = 0;
+			if (size < max_size)
+				size = std::min(size * 2, max_size);
+			return;
+		}
+		if (read_bytes >= size / 4) {
+			small_reads = 0;
+			return;
+		}
+		if (++small_reads < SHRINK_STREAK)
+			return;
+		small_reads = 0;
+		size = std::max(size / 2, min_size);
+	}
+
+	size_t min_size;
+	size_t max_size;
+	size_t size;
+	unsigned small_reads;
+};
+
 class NetworkEngine {
 public:
 	static int connectINET(const std::string_view& addr_str, unsigned port,
 			       size_t timeout);
+	/**
+	 * Create non-blocking socket and start connecting it. Connection
+	 * is established once socket becomes writable and socketError()
+	 * reports no error.
+	 */
+	static int connectINETAsync(const std::string_view& addr_str,
+				    unsigned port);
+	/** Pending error of the socket (e.g. result of connect). */
+	static int socketError(int socket);
 	static int connectUNIX(const std::string_view& path);
 	static void close(int socket);
 
@@ -94,12 +148,11 @@ public:
 	static int recv(int socket, struct iovec *iov, size_t iov_len);
 	static int recvall(int socket, struct iovec *iov, size_t iov_len,
 			   bool dont_wait);
-	static size_t readyToRecv(int socket);
+	static int readyToRecv(int socket);
 };
 
 inline int
-NetworkEngine::connectINET(const std::string_view& addr_str, unsigned port,
-			   size_t timeout)
+NetworkEngine::connectINETAsync(const std::string_view& addr_str, unsigned port)
 {
 	struct addrinfo hints, *res;
 	memset(&hints, 0, sizeof(hints));
@@ -124,8 +177,34 @@ NetworkEngine::connectINET(const std::string_view& addr_str, unsigned port,
 		freeaddrinfo(res);
 		return -1;
 	}
-	::connect(soc.fd, res->ai_addr, res->ai_addrlen);
+	int rc = ::connect(soc.fd, res->ai_addr, res->ai_addrlen);
 	freeaddrinfo(res);
+	if (rc != 0 && errno != EINPROGRESS) {
+		LOG_ERROR("connect() failed: ", strerror(errno));
+		return -1;
+	}
+	int sock = soc.fd;
+	soc.fd = -1;
+	return sock;
+}
+
+inline int
+NetworkEngine::socketError(int socket)
+{
+	int so_error = 0;
+	socklen_t len = sizeof(so_error);
+	if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &so_error, &len) != 0)
+		return errno;
+	return so_error;
+}
+
+inline int
+NetworkEngine::connectINET(const std::string_view& addr_str, unsigned port,
+			   size_t timeout)
+{
+	Socket soc(connectINETAsync(addr_str, port));
+	if (soc.fd < 0)
+		return -1;
 	/*
 	 * Now let's use select to timeout connect call. Once socket becomes
 	 * writable - connection is established.
@@ -147,12 +226,7 @@ NetworkEngine::connectINET(const std::string_view& addr_str, unsigned port,
 		return -1;
 	}
 	assert(rc == 1);
-	int so_error;
-	socklen_t len = sizeof(so_error);
-	if (getsockopt(soc.fd, SOL_SOCKET, SO_ERROR, &so_error, &len) != 0) {
-		LOG_ERROR("getsockopt() failed: ", strerror(errno));
-		return -1;
-	}
+	int so_error = socketError(soc.fd);
 	if (so_error != 0) {
 		LOG_ERROR("connect() failed: ", strerror(so_error));
 		return -1;
@@ -204,10 +278,11 @@ inline int
 NetworkEngine::send(int socket, struct iovec *iov, size_t iov_len)
 {
 	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
 	msg.msg_iov = iov;
 	msg.msg_iovlen = iov_len;
 
-	int flags = MSG_DONTWAIT;
+	int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
 	return sendmsg(socket, &msg, flags);
 }
 
@@ -228,12 +303,18 @@ NetworkEngine::sendall(int socket, struct iovec *iov, size_t iov_len,
 		if (rc == -1)
 			return -1;
 		*sent_bytes += rc;
-		while ((size_t) rc > iov->iov_len) {
-			rc -= iov->iov_len;
+		/* Skip sent iovecs and cut the head of partially sent one. */
+		size_t left = rc;
+		while (left > 0 && left >= iov->iov_len) {
+			left -= iov->iov_len;
 			iov = iov + 1;
 			assert(msg.msg_iovlen > 0);
 			msg.msg_iovlen--;
 		}
+		if (left > 0) {
+			iov->iov_base = (char *) iov->iov_base + left;
+			iov->iov_len -= left;
+		}
 		msg.msg_iov = iov;
 	}
 	return 0;
@@ -243,6 +324,7 @@ inline int
 NetworkEngine::recv(int socket, struct iovec *iov, size_t iov_len)
 {
 	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
 	msg.msg_iov = iov;
 	msg.msg_iovlen = iov_len;
 
@@ -274,7 +356,7 @@ NetworkEngine::recvall(int socket, struct iovec *iov, size_t iov_len,
 	return rc;
 }
 
-inline size_t
+inline int
 NetworkEngine::readyToRecv(int socket)
 {
 	int bytes = 0;
@@ -36,6 +36,7 @@
 #include "IprotoConstants.hpp"
 #include "../mpp/mpp.hpp"
 #include "../Utils/Logger.hpp"
+#include "../Utils/Sha1.hpp"
 
 enum IteratorType {
 	EQ = 0,
@@ -58,7 +59,8 @@ using iterator_t = typename BUFFER::iterator;
 template<class BUFFER>
 class RequestEncoder {
 public:
-	RequestEncoder(BUFFER &buf) : m_Buf(buf), m_Enc(buf) {};
+	RequestEncoder(BUFFER &buf) : m_Buf(buf), m_Enc(buf), m_Sync(-1),
+				      m_StreamId(0) {};
 	~RequestEncoder() { };
 	RequestEncoder() = delete;
 	RequestEncoder(const RequestEncoder& encoder) = delete;
@@ -84,14 +86,56 @@ public:
 			    IteratorType iterator = EQ);
 	template <class T>
 	size_t encodeCall(const std::string &func, const T &args);
+	/**
+	 * @a expr is any string: if it is known at compile time (tnt::CStr),
+	 * body map header, EXPR key and the expression itself are joined by
+	 * mpp into a single constant, so only sync and @a args are encoded
+	 * at runtime.
+	 */
+	template <class EXPR, class T>
+	size_t encodeEval(const EXPR &expr, const T &args);
+	/** Execute SQL @a statement binding @a parameters to it. */
+	template <class T>
+	size_t encodeExecute(const std::string &statement, const T &parameters);
+	/** Execute statement prepared earlier and identified by @a stmt_id. */
+	template <class T>
+	size_t encodeExecute(uint32_t stmt_id, const T &parameters);
+	size_t encodePrepare(const std::string &statement);
+	/** PREPARE request carrying only the id deallocates statement. */
+	size_t encodeUnprepare(uint32_t stmt_id);
+	/**
+	 * chap-sha1 authentication request. @a salt is the salt from
+	 * server's greeting, at least Iproto::SCRAMBLE_SIZE bytes.
+	 */
+	size_t encodeAuth(const std::string &user, const std::string &passwd,
+			  const char *salt);
+	/**
+	 * Start transaction in current stream. Zero @a timeout (in
+	 * seconds) means server's default.
+	 */
+	size_t encodeBegin(double timeout = 0,
+			   Iproto::TxnIsolation isolation =
+				Iproto::TXN_ISOLATION_DEFAULT);
+	size_t encodeCommit();
+	size_t encodeRollback();
 
-	/** Sync value is used as request id. */
-	static size_t getSync() { return sync; }
+	/**
+	 * Sync value is used as request id. Each encoder (i.e. connection)
+	 * issues its own dense sequence of syncs starting from 0.
+	 */
+	size_t getSync() const { return m_Sync; }
+	/**
+	 * Stamp @a stream_id into headers of requests encoded from now on;
+	 * 0 means no stream.
+	 */
+	void setStreamId(uint64_t stream_id) { m_StreamId = stream_id; }
+	uint64_t getStreamId() const { return m_StreamId; }
 private:
 	void encodeHeader(int request);
 	BUFFER &m_Buf;
 	mpp::Enc<BUFFER> m_Enc;
-	inline static ssize_t sync = -1;
+	ssize_t m_Sync;
+	uint64_t m_StreamId;
 	static constexpr size_t PREHEADER_SIZE = 5;
 };
 
@@ -99,10 +143,13 @@ template<class BUFFER>
 void
 RequestEncoder<BUFFER>::encodeHeader(int request)
 {
-	//TODO: add schema version.
-	m_Enc.add(mpp::as_map(std::forward_as_tuple(
-		MPP_AS_CONST(Iproto::SYNC), ++RequestEncoder::sync,
-		MPP_AS_CONST(Iproto::REQUEST_TYPE), request)));
+	/* Optional keys follow the fixmap header. */
+	uint8_t key_count = 2 + (m_StreamId != 0);
+	m_Buf.addBack(static_cast<uint8_t>(0x80 + key_count));
+	m_Enc.add(MPP_AS_CONST(Iproto::SYNC), ++m_Sync,
+		  MPP_AS_CONST(Iproto::REQUEST_TYPE), request);
+	if (m_StreamId != 0)
+		m_Enc.add(MPP_AS_CONST(Iproto::STREAM_ID), m_StreamId);
 }
 
 template<class BUFFER>
@@ -252,3 +299,170 @@ RequestEncoder<BUFFER>::encodeCall(const std::string &func, const T &args)
 	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
 	return request_size + PREHEADER_SIZE;
 }
+
+template<class BUFFER>
+template <class EXPR, class T>
+size_t
+RequestEncoder<BUFFER>::encodeEval(const EXPR &expr, const T &args)
+{
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::EVAL);
+	m_Enc.add(mpp::as_map(std::forward_as_tuple(
+		MPP_AS_CONST(Iproto::EXPR), expr,
+		MPP_AS_CONST(Iproto::TUPLE), mpp::as_arr(args))));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
+
+template<class BUFFER>
+template <class T>
+size_t
+RequestEncoder<BUFFER>::encodeExecute(const std::string &statement,
+				      const T &parameters)
+{
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::EXECUTE);
+	m_Enc.add(mpp::as_map(std::forward_as_tuple(
+		MPP_AS_CONST(Iproto::SQL_TEXT), statement,
+		MPP_AS_CONST(Iproto::SQL_BIND), mpp::as_arr(parameters),
+		MPP_AS_CONST(Iproto::OPTIONS), mpp::as_arr(std::make_tuple()))));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
+
+template<class BUFFER>
+template <class T>
+size_t
+RequestEncoder<BUFFER>::encodeExecute(uint32_t stmt_id, const T &parameters)
+{
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::EXECUTE);
+	m_Enc.add(mpp::as_map(std::forward_as_tuple(
+		MPP_AS_CONST(Iproto::STMT_ID), stmt_id,
+		MPP_AS_CONST(Iproto::SQL_BIND), mpp::as_arr(parameters),
+		MPP_AS_CONST(Iproto::OPTIONS), mpp::as_arr(std::make_tuple()))));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
+
+template<class BUFFER>
+size_t
+RequestEncoder<BUFFER>::encodePrepare(const std::string &statement)
+{
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::PREPARE);
+	m_Enc.add(mpp::as_map(std::forward_as_tuple(
+		MPP_AS_CONST(Iproto::SQL_TEXT), statement)));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
+
+template<class BUFFER>
+size_t
+RequestEncoder<BUFFER>::encodeUnprepare(uint32_t stmt_id)
+{
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::PREPARE);
+	m_Enc.add(mpp::as_map(std::forward_as_tuple(
+		MPP_AS_CONST(Iproto::STMT_ID), stmt_id)));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
+
+template<class BUFFER>
+size_t
+RequestEncoder<BUFFER>::encodeAuth(const std::string &user,
+				   const std::string &passwd, const char *salt)
+{
+	static_assert(sha1::DIGEST_SIZE == Iproto::SCRAMBLE_SIZE);
+	/* scramble = sha1(passwd) xor sha1(salt, sha1(sha1(passwd))) */
+	uint8_t hash1[sha1::DIGEST_SIZE];
+	uint8_t hash2[sha1::DIGEST_SIZE];
+	uint8_t hash3[sha1::DIGEST_SIZE];
+	sha1::digest(passwd.data(), passwd.size(), hash1);
+	sha1::digest(hash1, sizeof(hash1), hash2);
+	sha1::Context ctx;
+	ctx.update(salt, Iproto::SCRAMBLE_SIZE);
+	ctx.update(hash2, sizeof(hash2));
+	ctx.finish(hash3);
+	std::string scramble(Iproto::SCRAMBLE_SIZE, '\0');
+	for (size_t i = 0; i < Iproto::SCRAMBLE_SIZE; ++i)
+		scramble[i] = hash1[i] ^ hash3[i];
+
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::AUTH);
+	m_Enc.add(mpp::as_map(std::forward_as_tuple(
+		MPP_AS_CONST(Iproto::USER_NAME), user,
+		MPP_AS_CONST(Iproto::TUPLE),
+		std::make_tuple("chap-sha1", scramble))));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
+
+template<class BUFFER>
+size_t
+RequestEncoder<BUFFER>::encodeBegin(double timeout,
+				    Iproto::TxnIsolation isolation)
+{
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::TXN_BEGIN);
+	/* Server rejects non-positive timeout, so it's omitted. */
+	if (timeout > 0)
+		m_Enc.add(mpp::as_map(std::forward_as_tuple(
+			MPP_AS_CONST(Iproto::TIMEOUT), timeout,
+			MPP_AS_CONST(Iproto::TXN_ISOLATION), isolation)));
+	else
+		m_Enc.add(mpp::as_map(std::forward_as_tuple(
+			MPP_AS_CONST(Iproto::TXN_ISOLATION), isolation)));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
+
+template<class BUFFER>
+size_t
+RequestEncoder<BUFFER>::encodeCommit()
+{
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::TXN_COMMIT);
+	m_Enc.add(mpp::as_map(std::make_tuple()));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
+
+template<class BUFFER>
+size_t
+RequestEncoder<BUFFER>::encodeRollback()
+{
+	iterator_t<BUFFER> request_start = m_Buf.end();
+	m_Buf.addBack('\xce');
+	m_Buf.addBack(uint32_t{0});
+	encodeHeader(Iproto::TXN_ROLLBACK);
+	m_Enc.add(mpp::as_map(std::make_tuple()));
+	uint32_t request_size = (m_Buf.end() - request_start) - PREHEADER_SIZE;
+	m_Buf.set(request_start + 1, __builtin_bswap32(request_size));
+	return request_size + PREHEADER_SIZE;
+}
@@ -31,6 +31,7 @@
  */
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <tuple>
 #include <vector>
 
@@ -84,10 +85,33 @@ struct Data {
 	iterator_t<BUFFER> end;
 };
 
+/** Description of a column of SQL result set. */
+struct ColumnMap {
+	std::string field_name;
+	std::string field_type;
+	std::string collation;
+	bool is_nullable = false;
+	bool is_autoincrement = false;
+};
+
+/** Result of SQL statement which does not return rows (DML, DDL). */
+struct SqlInfo {
+	uint64_t row_count = 0;
+	/** Values generated for AUTOINCREMENT fields, if any. */
+	std::vector<int64_t> autoincrement_ids;
+};
+
 template<class BUFFER>
 struct Body {
 	std::optional<ErrorStack> error_stack;
 	std::optional<Data<BUFFER>> data;
+	/** SQL: columns of result set or of prepared statement. */
+	std::optional<std::vector<ColumnMap>> metadata;
+	std::optional<SqlInfo> sql_info;
+	/** PREPARE: id of the prepared statement. */
+	std::optional<uint32_t> stmt_id;
+	/** PREPARE: count of parameters to bind. */
+	std::optional<uint32_t> bind_count;
 };
 
 template<class BUFFER>
@@ -355,6 +379,178 @@ struct ErrorReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_MAP> {
 };
 
 
+/**
+ * Skip value of any type. Scalars are consumed by decoder itself,
+ * content of containers is skipped explicitly.
+ */
+template <class BUFFER>
+struct SkipReader : mpp::ReaderTemplate<BUFFER> {
+
+	SkipReader(mpp::Dec<BUFFER>& d) : dec(d) {}
+
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::ArrValue)
+	{
+		dec.Skip();
+	}
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::MapValue)
+	{
+		dec.Skip();
+	}
+	template <class T>
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, T&&) {}
+	mpp::Dec<BUFFER>& dec;
+};
+
+template <class BUFFER>
+struct StringReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_STR> {
+
+	StringReader(std::string& s) : str(s) {}
+
+	void Value(iterator_t<BUFFER>& itr, mpp::compact::Type,
+		   const mpp::StrValue& v)
+	{
+		str.resize(v.size);
+		iterator_t<BUFFER> walker = itr;
+		walker += v.offset;
+		for (size_t i = 0; i < v.size; i++) {
+			str[i] = *walker;
+			++walker;
+		}
+	}
+	std::string& str;
+};
+
+template <class BUFFER>
+struct ColumnMapKeyReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_UINT> {
+
+	ColumnMapKeyReader(mpp::Dec<BUFFER>& d, ColumnMap& c) :
+		dec(d), column(c) {}
+
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, uint64_t key)
+	{
+		using Str_t = StringReader<BUFFER>;
+		using Bool_t = mpp::SimpleReader<BUFFER, mpp::MP_BOOL, bool>;
+		switch (key) {
+			case Iproto::FIELD_NAME:
+				dec.SetReader(true, Str_t{column.field_name});
+				break;
+			case Iproto::FIELD_TYPE:
+				dec.SetReader(true, Str_t{column.field_type});
+				break;
+			case Iproto::FIELD_COLL:
+				dec.SetReader(true, Str_t{column.collation});
+				break;
+			case Iproto::FIELD_IS_NULLABLE:
+				dec.SetReader(true, Bool_t{column.is_nullable});
+				break;
+			case Iproto::FIELD_IS_AUTOINCREMENT:
+				dec.SetReader(true, Bool_t{column.is_autoincrement});
+				break;
+			default:
+				/* FIELD_SPAN and keys of newer versions. */
+				dec.SetReader(true, SkipReader<BUFFER>{dec});
+		}
+	}
+	mpp::Dec<BUFFER>& dec;
+	ColumnMap& column;
+};
+
+template <class BUFFER>
+struct ColumnMapReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_MAP> {
+
+	ColumnMapReader(mpp::Dec<BUFFER>& d, std::vector<ColumnMap>& m) :
+		dec(d), metadata(m) {}
+
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::MapValue)
+	{
+		metadata.emplace_back();
+		dec.SetReader(false, ColumnMapKeyReader<BUFFER>{dec, metadata.back()});
+	}
+	mpp::Dec<BUFFER>& dec;
+	std::vector<ColumnMap>& metadata;
+};
+
+template <class BUFFER>
+struct MetadataReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_ARR> {
+
+	MetadataReader(mpp::Dec<BUFFER>& d, std::vector<ColumnMap>& m) :
+		dec(d), metadata(m) {}
+
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::ArrValue u)
+	{
+		metadata.reserve(u.size);
+		dec.SetReader(false, ColumnMapReader<BUFFER>{dec, metadata});
+	}
+	mpp::Dec<BUFFER>& dec;
+	std::vector<ColumnMap>& metadata;
+};
+
+template <class BUFFER>
+struct AutoincrementIdReader :
+	mpp::SimpleReaderBase<BUFFER, mpp::MP_UINT | mpp::MP_INT> {
+
+	AutoincrementIdReader(std::vector<int64_t>& i) : ids(i) {}
+
+	template <class T>
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, T id)
+	{
+		ids.push_back(id);
+	}
+	std::vector<int64_t>& ids;
+};
+
+template <class BUFFER>
+struct AutoincrementIdsReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_ARR> {
+
+	AutoincrementIdsReader(mpp::Dec<BUFFER>& d, std::vector<int64_t>& i) :
+		dec(d), ids(i) {}
+
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::ArrValue u)
+	{
+		ids.reserve(u.size);
+		dec.SetReader(false, AutoincrementIdReader<BUFFER>{ids});
+	}
+	mpp::Dec<BUFFER>& dec;
+	std::vector<int64_t>& ids;
+};
+
+template <class BUFFER>
+struct SqlInfoKeyReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_UINT> {
+
+	SqlInfoKeyReader(mpp::Dec<BUFFER>& d, SqlInfo& i) : dec(d), info(i) {}
+
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, uint64_t key)
+	{
+		using Uint_t = mpp::SimpleReader<BUFFER, mpp::MP_UINT, uint64_t>;
+		using Ids_t = AutoincrementIdsReader<BUFFER>;
+		switch (key) {
+			case Iproto::SQL_INFO_ROW_COUNT:
+				dec.SetReader(true, Uint_t{info.row_count});
+				break;
+			case Iproto::SQL_INFO_AUTOINCREMENT_IDS:
+				dec.SetReader(true, Ids_t{dec, info.autoincrement_ids});
+				break;
+			default:
+				dec.SetReader(true, SkipReader<BUFFER>{dec});
+		}
+	}
+	mpp::Dec<BUFFER>& dec;
+	SqlInfo& info;
+};
+
+template <class BUFFER>
+struct SqlInfoReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_MAP> {
+
+	SqlInfoReader(mpp::Dec<BUFFER>& d, SqlInfo& i) : dec(d), info(i) {}
+
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::MapValue)
+	{
+		dec.SetReader(false, SqlInfoKeyReader<BUFFER>{dec, info});
+	}
+	mpp::Dec<BUFFER>& dec;
+	SqlInfo& info;
+};
+
 template <class BUFFER>
 struct BodyKeyReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_UINT> {
 
@@ -365,6 +561,9 @@ struct BodyKeyReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_UINT> {
 		using Str_t = mpp::SimpleStrReader<BUFFER, sizeof(Error{}.msg)>;
 		using Err_t = ErrorReader<BUFFER>;
 		using Data_t = DataReader<BUFFER>;
+		using Metadata_t = MetadataReader<BUFFER>;
+		using SqlInfo_t = SqlInfoReader<BUFFER>;
+		using Uint32_t = mpp::SimpleReader<BUFFER, mpp::MP_UINT, uint32_t>;
 		switch (key) {
 			case Iproto::DATA: {
 				body.data = Data<BUFFER>(itr);
@@ -384,6 +583,30 @@ struct BodyKeyReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_UINT> {
 				dec.SetReader(true, Err_t{dec, error_stack});
 				break;
 			}
+			case Iproto::METADATA: {
+				body.metadata = std::vector<ColumnMap>();
+				dec.SetReader(true, Metadata_t{dec, *body.metadata});
+				break;
+			}
+			case Iproto::SQL_INFO: {
+				body.sql_info = SqlInfo();
+				dec.SetReader(true, SqlInfo_t{dec, *body.sql_info});
+				break;
+			}
+			case Iproto::STMT_ID: {
+				body.stmt_id = 0;
+				dec.SetReader(true, Uint32_t{*body.stmt_id});
+				break;
+			}
+			case Iproto::BIND_COUNT: {
+				body.bind_count = 0;
+				dec.SetReader(true, Uint32_t{*body.bind_count});
+				break;
+			}
+			case Iproto::BIND_METADATA: {
+				dec.SetReader(true, SkipReader<BUFFER>{dec});
+				break;
+			}
 			default:
 				LOG_ERROR("Invalid body key: ", key);
 				dec.AbortAndSkipRead();
@@ -0,0 +1,217 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "Connector.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Scatter-gather select: the same select is sent to several connections
+ * (e.g. shards of a partitioned space) at once, and the tuples of all
+ * responses are merged in order of the index key, as if they were
+ * selected from one space. Tuples are not copied: merge() passes
+ * references to the tuples in input buffers of the connections.
+ *
+ * ScatterSelect<Buf_t, Net_t> select(client);
+ * if (select.execute(conns, conn_count, space_id, index_id, key, limit,
+ *		      offset, GE, timeout) == 0)
+ *	select.merge(key_of, on_tuple);
+ */
+template<class BUFFER, class NetProvider = DefaultNetProvider<BUFFER, NetworkEngine>>
+class ScatterSelect
+{
+public:
+	using Conn_t = Connection<BUFFER, NetProvider>;
+
+	explicit ScatterSelect(Connector<BUFFER, NetProvider> &connector) :
+		m_Connector(connector), m_Limit(0), m_Offset(0),
+		m_IsDescending(false) {}
+	ScatterSelect(const ScatterSelect &) = delete;
+	ScatterSelect &operator=(const ScatterSelect &) = delete;
+
+	/**
+	 * Send select to all @a conns and wait for the responses. Each
+	 * connection is asked for @a limit + @a offset tuples since offset
+	 * and limit are applied to the merged result. Return 0 on success,
+	 * -1 on timeout, connection failure or error response (see
+	 * getError()). On timeout or failure the responses which are not
+	 * received yet are dropped once they arrive.
+	 */
+	template<class T>
+	int execute(Conn_t *const *conns, size_t conn_count,
+		    uint32_t space_id, uint32_t index_id, const T &key,
+		    uint32_t limit = UINT32_MAX, uint32_t offset = 0,
+		    IteratorType iterator = EQ, int timeout = 0);
+	/**
+	 * Invoke @a on_tuple(Conn_t &, Tuple<BUFFER> &) for the merged
+	 * tuples in order of their keys, skipping global offset and up to
+	 * global limit. Key of each tuple is extracted once by
+	 * @a key_of(Conn_t &, Tuple<BUFFER> &) and must be comparable
+	 * with operator <. Order is descending for LT, LE and REQ
+	 * iterators. Return count of tuples passed to @a on_tuple.
+	 */
+	template<class KEY_OF, class ON_TUPLE>
+	size_t merge(KEY_OF &&key_of, ON_TUPLE &&on_tuple);
+	/** Error message of the first failed response of execute(). */
+	const std::string &getError() const { return m_Error; }
+private:
+	/** Drop responses of all connections, now or once decoded. */
+	void discardResponses();
+
+	Connector<BUFFER, NetProvider> &m_Connector;
+	std::vector<Conn_t *> m_Conns;
+	std::vector<rid_t> m_Futures;
+	std::vector<std::optional<Response<BUFFER>>> m_Responses;
+	uint32_t m_Limit;
+	uint32_t m_Offset;
+	bool m_IsDescending;
+	std::string m_Error;
+};
+
+template<class BUFFER, class NetProvider>
+template<class T>
+int
+ScatterSelect<BUFFER, NetProvider>::execute(Conn_t *const *conns,
+					    size_t conn_count,
+					    uint32_t space_id,
+					    uint32_t index_id, const T &key,
+					    uint32_t limit, uint32_t offset,
+					    IteratorType iterator, int timeout)
+{
+	m_Conns.assign(conns, conns + conn_count);
+	m_Futures.resize(conn_count);
+	m_Responses.clear();
+	m_Error.clear();
+	m_Limit = limit;
+	m_Offset = offset;
+	m_IsDescending = iterator == REQ || iterator == LT || iterator == LE;
+	uint32_t conn_limit = limit > UINT32_MAX - offset ?
+			      UINT32_MAX : limit + offset;
+	for (size_t i = 0; i < conn_count; ++i) {
+		m_Futures[i] = m_Conns[i]->space[space_id].index[index_id].
+			select(key, conn_limit, 0, iterator);
+	}
+	Timer timer{timeout};
+	timer.start();
+	for (size_t i = 0; i < conn_count; ++i) {
+		/* Zero means infinite wait, so never pass it by accident. */
+		int left = timeout == 0 ? 0 :
+			   std::max(timeout - timer.elapsed(), 1);
+		int rc = m_Connector.waitAll(*m_Conns[i], &m_Futures[i], 1,
+					     left);
+		if (rc != 0) {
+			m_Error = m_Conns[i]->status.is_failed ?
+				  m_Conns[i]->getError() :
+				  std::string("Scatter select is timed out");
+			discardResponses();
+			return -1;
+		}
+	}
+	m_Responses.reserve(conn_count);
+	for (size_t i = 0; i < conn_count; ++i) {
+		m_Responses.push_back(m_Conns[i]->getResponse(m_Futures[i]));
+		const Body<BUFFER> &body = m_Responses.back()->body;
+		if (body.error_stack != std::nullopt && m_Error.empty())
+			m_Error.assign(body.error_stack->error.msg,
+				       body.error_stack->error.msg_len);
+	}
+	return m_Error.empty() ? 0 : -1;
+}
+
+template<class BUFFER, class NetProvider>
+void
+ScatterSelect<BUFFER, NetProvider>::discardResponses()
+{
+	for (size_t i = 0; i < m_Conns.size(); ++i)
+		m_Conns[i]->onResponse(m_Futures[i], [](Response<BUFFER> &) {});
+}
+
+template<class BUFFER, class NetProvider>
+template<class KEY_OF, class ON_TUPLE>
+size_t
+ScatterSelect<BUFFER, NetProvider>::merge(KEY_OF &&key_of,
+					  ON_TUPLE &&on_tuple)
+{
+	using Key_t = std::decay_t<std::invoke_result_t<KEY_OF, Conn_t &,
+						       Tuple<BUFFER> &>>;
+	/* Head of not merged tuples of one response. */
+	struct Cursor {
+		Key_t key;
+		size_t conn;
+		size_t pos;
+	};
+	bool desc = m_IsDescending;
+	/* priority_queue pops the greatest, so invert the order. */
+	auto later = [desc](const Cursor &a, const Cursor &b) {
+		if (a.key < b.key)
+			return desc;
+		if (b.key < a.key)
+			return !desc;
+		/* Keep tuples with equal keys in order of connections. */
+		return a.conn > b.conn;
+	};
+	std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)>
+		heads(later);
+	auto tuples = [this](size_t conn) -> std::vector<Tuple<BUFFER>> & {
+		return m_Responses[conn]->body.data->tuples;
+	};
+	for (size_t i = 0; i < m_Responses.size(); ++i) {
+		if (m_Responses[i] == std::nullopt ||
+		    m_Responses[i]->body.data == std::nullopt ||
+		    tuples(i).empty())
+			continue;
+		heads.push(Cursor{key_of(*m_Conns[i], tuples(i)[0]), i, 0});
+	}
+	size_t skipped = 0;
+	size_t passed = 0;
+	while (! heads.empty() && passed < m_Limit) {
+		Cursor head = heads.top();
+		heads.pop();
+		Tuple<BUFFER> &tuple = tuples(head.conn)[head.pos];
+		if (skipped < m_Offset) {
+			++skipped;
+		} else {
+			on_tuple(*m_Conns[head.conn], tuple);
+			++passed;
+		}
+		if (++head.pos < tuples(head.conn).size()) {
+			head.key = key_of(*m_Conns[head.conn],
+					  tuples(head.conn)[head.pos]);
+			heads.push(std::move(head));
+		}
+	}
+	return passed;
+}
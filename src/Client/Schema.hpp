@@ -0,0 +1,239 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "ResponseReader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Names of spaces and indexes of one schema version, fetched from system
+ * views _vspace and _vindex. Names are kept in sorted arrays, so lookup
+ * is a binary search without any allocation.
+ */
+class Schema {
+public:
+	/** Space id never used by server: unknown names resolve to it. */
+	static constexpr uint32_t NO_ID = UINT32_MAX;
+	static constexpr uint32_t VSPACE_ID = 281;
+	static constexpr uint32_t VINDEX_ID = 289;
+
+	std::optional<uint32_t> findSpace(std::string_view name) const;
+	std::optional<uint32_t> findIndex(uint32_t space_id,
+					  std::string_view name) const;
+	/** Schema version (SCHEMA_VERSION); 0 - schema is not loaded. */
+	uint64_t getVersion() const { return m_Version; }
+	size_t spaceCount() const { return m_Spaces.size(); }
+
+	void addSpace(uint32_t space_id, std::string name);
+	void addIndex(uint32_t space_id, uint32_t index_id, std::string name);
+	/** Sort names for lookup: schema is complete. */
+	void build(uint64_t version);
+	void clear();
+
+	/**
+	 * Decode tuples of _vspace (or _vindex if @a is_index) selected
+	 * into @a data. Return false if tuples are malformed.
+	 */
+	template <class BUFFER>
+	bool decode(BUFFER &buf, Data<BUFFER> &data, bool is_index);
+
+private:
+	struct SpaceName {
+		std::string name;
+		uint32_t space_id;
+	};
+	struct IndexName {
+		uint32_t space_id;
+		std::string name;
+		uint32_t index_id;
+	};
+	/** Sorted by name. */
+	std::vector<SpaceName> m_Spaces;
+	/** Sorted by space id and name. */
+	std::vector<IndexName> m_Indexes;
+	uint64_t m_Version = 0;
+};
+
+inline std::optional<uint32_t>
+Schema::findSpace(std::string_view name) const
+{
+	auto it = std::lower_bound(m_Spaces.begin(), m_Spaces.end(), name,
+				   [](const SpaceName &s, std::string_view n) {
+		return s.name < n;
+	});
+	if (it == m_Spaces.end() || it->name != name)
+		return std::nullopt;
+	return it->space_id;
+}
+
+inline std::optional<uint32_t>
+Schema::findIndex(uint32_t space_id, std::string_view name) const
+{
+	auto it = std::lower_bound(m_Indexes.begin(), m_Indexes.end(),
+				   std::make_pair(space_id, name),
+				   [](const IndexName &i,
+				      const std::pair<uint32_t, std::string_view> &k) {
+		return i.space_id < k.first ||
+		       (i.space_id == k.first && i.name < k.second);
+	});
+	if (it == m_Indexes.end() || it->space_id != space_id ||
+	    it->name != name)
+		return std::nullopt;
+	return it->index_id;
+}
+
+inline void
+Schema::addSpace(uint32_t space_id, std::string name)
+{
+	m_Spaces.push_back({std::move(name), space_id});
+}
+
+inline void
+Schema::addIndex(uint32_t space_id, uint32_t index_id, std::string name)
+{
+	m_Indexes.push_back({space_id, std::move(name), index_id});
+}
+
+inline void
+Schema::build(uint64_t version)
+{
+	std::sort(m_Spaces.begin(), m_Spaces.end(),
+		  [](const SpaceName &a, const SpaceName &b) {
+		return a.name < b.name;
+	});
+	std::sort(m_Indexes.begin(), m_Indexes.end(),
+		  [](const IndexName &a, const IndexName &b) {
+		return a.space_id < b.space_id ||
+		       (a.space_id == b.space_id && a.name < b.name);
+	});
+	m_Version = version;
+}
+
+inline void
+Schema::clear()
+{
+	m_Spaces.clear();
+	m_Indexes.clear();
+	m_Version = 0;
+}
+
+/**
+ * Leading fields of _vspace tuple (id, owner, name, ...) or _vindex
+ * tuple (space id, index id, name, ...).
+ */
+struct SchemaTupleFields {
+	uint64_t id[2] = {0, 0};
+	std::string name;
+};
+
+template <class BUFFER>
+struct SchemaFieldReader : mpp::ReaderTemplate<BUFFER> {
+
+	SchemaFieldReader(mpp::Dec<BUFFER>& d, SchemaTupleFields& f) :
+		dec(d), fields(f) {}
+
+	void Value(iterator_t<BUFFER>& itr, mpp::compact::Type,
+		   mpp::StrValue v)
+	{
+		if (field_no++ != 2)
+			return;
+		fields.name.resize(v.size);
+		iterator_t<BUFFER> walker = itr;
+		walker += v.offset;
+		for (size_t i = 0; i < v.size; i++) {
+			fields.name[i] = *walker;
+			++walker;
+		}
+	}
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::ArrValue)
+	{
+		field_no++;
+		dec.Skip();
+	}
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::MapValue)
+	{
+		field_no++;
+		dec.Skip();
+	}
+	template <class T>
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, T v)
+	{
+		if constexpr (std::is_integral_v<T>) {
+			if (field_no < 2)
+				fields.id[field_no] = v;
+		}
+		field_no++;
+	}
+	mpp::Dec<BUFFER>& dec;
+	SchemaTupleFields& fields;
+	size_t field_no = 0;
+};
+
+template <class BUFFER>
+struct SchemaTupleReader : mpp::SimpleReaderBase<BUFFER, mpp::MP_ARR> {
+
+	SchemaTupleReader(mpp::Dec<BUFFER>& d, SchemaTupleFields& f) :
+		dec(d), fields(f) {}
+
+	void Value(const iterator_t<BUFFER>&, mpp::compact::Type, mpp::ArrValue)
+	{
+		dec.SetReader(false, SchemaFieldReader<BUFFER>{dec, fields});
+	}
+	mpp::Dec<BUFFER>& dec;
+	SchemaTupleFields& fields;
+};
+
+template <class BUFFER>
+bool
+Schema::decode(BUFFER &buf, Data<BUFFER> &data, bool is_index)
+{
+	mpp::Dec<BUFFER> dec(buf);
+	for (auto &t : data.tuples) {
+		if (t.field_count < 3)
+			return false;
+		SchemaTupleFields fields;
+		dec.SetPosition(t.begin);
+		dec.SetReader(false, SchemaTupleReader<BUFFER>{dec, fields});
+		if (dec.Read() != mpp::READ_SUCCESS)
+			return false;
+		if (is_index)
+			addIndex(fields.id[0], fields.id[1],
+				 std::move(fields.name));
+		else
+			addSpace(fields.id[0], std::move(fields.name));
+	}
+	return true;
+}
@@ -0,0 +1,197 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "ConnectionPool.hpp"
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+/** Request routed to a shard: shard number and future of its connection. */
+struct ShardFuture {
+	size_t shard;
+	rid_t future;
+};
+
+/**
+ * Client of data sharded over several instances in vshard manner: key is
+ * hashed to one of a fixed number of buckets and each bucket is stored on
+ * exactly one shard according to the routing table. Routing is just two
+ * array lookups, and the table can be changed (e.g. when buckets are moved
+ * between shards) with setRoute(). Routes set explicitly are kept when
+ * the rest of buckets are redistributed by addShard().
+ *
+ * Requests are encoded by the usual Connection API on the connection
+ * returned by route(), so all requests to the same shard are batched by
+ * its connection and sent on wait. Responses are collected from all the
+ * shards in one wait loop.
+ *
+ * @a HASH maps key to an integer; bucket of the key is the hash modulo
+ * bucket count. Note that the default std::hash % bucket_count mapping is
+ * NOT compatible with vshard, which maps keys with crc32 and numbers
+ * buckets from 1 (vshard.router.bucket_id_strcrc32()). To talk to a vshard
+ * cluster, provide @a HASH computing the same bucket ids.
+ */
+template<class BUFFER, class NetProvider = DefaultNetProvider<BUFFER, NetworkEngine>,
+	 template<class> class HASH = std::hash>
+class ShardedClient
+{
+public:
+	using Conn_t = Connection<BUFFER, NetProvider>;
+
+	ShardedClient(Connector<BUFFER, NetProvider> &connector,
+		      uint32_t bucket_count = DEFAULT_BUCKET_COUNT);
+	ShardedClient(const ShardedClient &) = delete;
+	ShardedClient &operator=(const ShardedClient &) = delete;
+
+	/**
+	 * Connect to one more shard. Buckets are redistributed evenly
+	 * between shards in contiguous ranges, except for the ones moved
+	 * with setRoute(). Return number of the shard or -1 on failure.
+	 */
+	int addShard(const std::string_view &addr, unsigned port);
+	size_t shardCount() const { return m_Shards.size(); }
+	Conn_t &shard(size_t shard) { return m_Shards[shard]; }
+
+	uint32_t bucketCount() const { return m_Routes.size(); }
+	template<class K>
+	uint32_t bucketOf(const K &key) const
+	{
+		return HASH<K>{}(key) % m_Routes.size();
+	}
+	/** Move @a bucket to @a shard; addShard() won't move it back. */
+	void setRoute(uint32_t bucket, size_t shard);
+	size_t shardOfBucket(uint32_t bucket) const { return m_Routes[bucket]; }
+	template<class K>
+	size_t shardOf(const K &key) const
+	{
+		return m_Routes[bucketOf(key)];
+	}
+	/** Connection of the shard storing @a key. */
+	template<class K>
+	Conn_t &route(const K &key) { return shard(shardOf(key)); }
+
+	/**
+	 * Encode request on the connection of @a key's shard:
+	 * @a request is invoked with the connection and returns future.
+	 * client.send(key, [&](auto &conn) {
+	 *	return conn.space[512].replace(tuple);
+	 * });
+	 */
+	template<class K, class REQUEST>
+	ShardFuture send(const K &key, REQUEST &&request);
+	std::optional<Response<BUFFER>> getResponse(const ShardFuture &future);
+	bool futureIsReady(const ShardFuture &future);
+
+	/**
+	 * Wait for responses to all requests sent to the shards. Return 0
+	 * on success, -1 on timeout or failure of some shard.
+	 */
+	int waitAll(int timeout = 0) { return m_Shards.waitAll(timeout); }
+	void close() { m_Shards.close(); }
+
+	/** vshard default. */
+	static constexpr uint32_t DEFAULT_BUCKET_COUNT = 3000;
+private:
+	ConnectionPool<BUFFER, NetProvider> m_Shards;
+	/** Shard number of each bucket. */
+	std::vector<uint32_t> m_Routes;
+	/** Buckets routed by setRoute(), they are not rebalanced. */
+	std::vector<bool> m_IsExplicit;
+
+	void rebalance();
+};
+
+template<class BUFFER, class NetProvider, template<class> class HASH>
+ShardedClient<BUFFER, NetProvider, HASH>::ShardedClient(Connector<BUFFER, NetProvider> &connector,
+							uint32_t bucket_count) :
+	m_Shards(connector), m_Routes(bucket_count, 0),
+	m_IsExplicit(bucket_count, false)
+{
+	assert(bucket_count > 0);
+}
+
+template<class BUFFER, class NetProvider, template<class> class HASH>
+int
+ShardedClient<BUFFER, NetProvider, HASH>::addShard(const std::string_view &addr,
+						   unsigned port)
+{
+	if (m_Shards.connect(addr, port, 1) != 0)
+		return -1;
+	rebalance();
+	return m_Shards.size() - 1;
+}
+
+template<class BUFFER, class NetProvider, template<class> class HASH>
+void
+ShardedClient<BUFFER, NetProvider, HASH>::rebalance()
+{
+	size_t shard_count = m_Shards.size();
+	size_t bucket_count = m_Routes.size();
+	for (size_t i = 0; i < bucket_count; ++i) {
+		if (! m_IsExplicit[i])
+			m_Routes[i] = i * shard_count / bucket_count;
+	}
+}
+
+template<class BUFFER, class NetProvider, template<class> class HASH>
+void
+ShardedClient<BUFFER, NetProvider, HASH>::setRoute(uint32_t bucket,
+						   size_t shard)
+{
+	assert(bucket < m_Routes.size());
+	assert(shard < m_Shards.size());
+	m_Routes[bucket] = shard;
+	m_IsExplicit[bucket] = true;
+}
+
+template<class BUFFER, class NetProvider, template<class> class HASH>
+template<class K, class REQUEST>
+ShardFuture
+ShardedClient<BUFFER, NetProvider, HASH>::send(const K &key, REQUEST &&request)
+{
+	size_t shard = shardOf(key);
+	return ShardFuture{shard, request(m_Shards[shard])};
+}
+
+template<class BUFFER, class NetProvider, template<class> class HASH>
+std::optional<Response<BUFFER>>
+ShardedClient<BUFFER, NetProvider, HASH>::getResponse(const ShardFuture &future)
+{
+	return m_Shards[future.shard].getResponse(future.future);
+}
+
+template<class BUFFER, class NetProvider, template<class> class HASH>
+bool
+ShardedClient<BUFFER, NetProvider, HASH>::futureIsReady(const ShardFuture &future)
+{
+	return m_Shards[future.shard].futureIsReady(future.future);
+}
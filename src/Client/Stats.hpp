@@ -0,0 +1,288 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "IprotoConstants.hpp"
+#include "../Utils/Histogram.hpp"
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Statistics are cheap (a few increments and two clock reads per request),
+ * so they are enabled by default. Build with TNTCXX_ENABLE_STATS=0 to
+ * compile them out completely.
+ */
+#ifndef TNTCXX_ENABLE_STATS
+#define TNTCXX_ENABLE_STATS 1
+#endif
+
+/** Statistics concerning requests/responses. */
+struct ConnectionStat {
+	/** Count of encoded requests. */
+	size_t send;
+	/** Count of decoded responses. */
+	size_t read;
+	/**
+	 * Count of requests failed locally without response (e.g. when
+	 * connection is lost). They are not accounted in latency.
+	 */
+	size_t failed;
+	/**
+	 * Count of requests completed with timeout error. Their late
+	 * responses are counted as read but not accounted in latency.
+	 */
+	size_t timed_out;
+	/** Count of bytes written to and read from sockets. */
+	size_t bytes_sent;
+	size_t bytes_received;
+	/** Count of send and receive syscalls (or io_uring operations). */
+	size_t send_calls;
+	size_t recv_calls;
+	/** Count of sends which have written less than was requested. */
+	size_t partial_writes;
+	/**
+	 * Count of flushes, i.e. hand-overs of held requests to network
+	 * provider, and count of requests handed over by them.
+	 */
+	size_t flushes;
+	size_t flushed_requests;
+	/** Count of flushes triggered by each of reasons. */
+	size_t flush_by_bytes;
+	size_t flush_by_requests;
+	size_t flush_by_delay;
+	size_t flush_by_wait;
+	size_t flush_explicit;
+};
+
+/** Nanoseconds passed from encoding of a request to decoding of response. */
+using LatencyHistogram = tnt::Histogram<>;
+
+/**
+ * Type and encoding time of a request. It is kept by the connection along
+ * with the rest of request's state until response is decoded.
+ */
+template <bool ENABLE_STATS>
+struct RequestStamp {
+	uint32_t type;
+	std::chrono::steady_clock::time_point encoded;
+};
+
+/** Disabled statistics: empty stamp takes no space being a base class. */
+template <>
+struct RequestStamp<false> {};
+
+using RequestStamp_t = RequestStamp<TNTCXX_ENABLE_STATS != 0>;
+
+/**
+ * Statistics of a connection. Each update is also applied to statistics
+ * of @a aggregate (if any), so the connector accumulates statistics of all
+ * its connections without locks and walking over them.
+ * Latency histograms are kept per request type: types below
+ * Iproto::TYPE_STAT_MAX have their own histograms, the rest of types
+ * (e.g. PING) share the histogram of Iproto::OK slot. Histogram of a type
+ * is allocated when its first response is decoded.
+ */
+template <bool ENABLE_STATS>
+class ConnectionStats {
+public:
+	explicit ConnectionStats(ConnectionStats *aggregate = nullptr) :
+		m_Stat(), m_Aggregate(aggregate) {}
+	ConnectionStats(const ConnectionStats &) = delete;
+	ConnectionStats &operator=(const ConnectionStats &) = delete;
+
+	const ConnectionStat &stat() const { return m_Stat; }
+	/** Latency of requests of @a type or nullptr if there were none. */
+	const LatencyHistogram *latency(uint32_t type) const
+	{
+		return m_Latency[typeSlot(type)].get();
+	}
+
+	/** Request of @a type is encoded, fill in its @a stamp. */
+	void requestEncoded(RequestStamp<ENABLE_STATS> &stamp, uint32_t type);
+	/**
+	 * Response is decoded. @a stamp is nullptr if the request is not
+	 * pending anymore (e.g. expired one).
+	 */
+	void responseDecoded(const RequestStamp<ENABLE_STATS> *stamp);
+	/** Request is completed with a locally made error. */
+	void requestFailed();
+	/** Request is completed with timeout error. */
+	void requestTimedOut();
+	/** @a rc is result of send syscall of @a iov_cnt vectors @a iov. */
+	void sendCalled(const struct iovec *iov, size_t iov_cnt, ssize_t rc);
+	void recvCalled(ssize_t rc);
+	/**
+	 * @a requests have been handed over to network provider. If
+	 * @a reason is not null, it is counter of the flush reason.
+	 */
+	void flushed(size_t requests, size_t ConnectionStat::*reason);
+private:
+	using Clock_t = std::chrono::steady_clock;
+
+	static size_t typeSlot(uint32_t type)
+	{
+		return type < Iproto::TYPE_STAT_MAX ? type : (size_t) Iproto::OK;
+	}
+	void recordLatency(size_t slot, uint64_t latency);
+
+	ConnectionStat m_Stat;
+	std::unique_ptr<LatencyHistogram> m_Latency[Iproto::TYPE_STAT_MAX];
+	ConnectionStats *m_Aggregate;
+};
+
+/** Disabled statistics: all updates are no-ops, all counters are zero. */
+template <>
+class ConnectionStats<false> {
+public:
+	explicit ConnectionStats(ConnectionStats * = nullptr) {}
+	ConnectionStats(const ConnectionStats &) = delete;
+	ConnectionStats &operator=(const ConnectionStats &) = delete;
+
+	const ConnectionStat &stat() const
+	{
+		static const ConnectionStat zero = {};
+		return zero;
+	}
+	/** Disabled. return nullptr. */
+	const LatencyHistogram *latency(uint32_t) const { return nullptr; }
+
+	void requestEncoded(RequestStamp<false> &, uint32_t) {}
+	void responseDecoded(const RequestStamp<false> *) {}
+	void requestFailed() {}
+	void requestTimedOut() {}
+	void sendCalled(const struct iovec *, size_t, ssize_t) {}
+	void recvCalled(ssize_t) {}
+	void flushed(size_t, size_t ConnectionStat::*) {}
+};
+
+using ConnectionStats_t = ConnectionStats<TNTCXX_ENABLE_STATS != 0>;
+
+template <bool ENABLE_STATS>
+void
+ConnectionStats<ENABLE_STATS>::requestEncoded(RequestStamp<ENABLE_STATS> &stamp,
+					      uint32_t type)
+{
+	for (ConnectionStats *s = this; s != nullptr; s = s->m_Aggregate)
+		s->m_Stat.send++;
+	stamp.type = type;
+	stamp.encoded = Clock_t::now();
+}
+
+template <bool ENABLE_STATS>
+void
+ConnectionStats<ENABLE_STATS>::responseDecoded(const RequestStamp<ENABLE_STATS> *stamp)
+{
+	for (ConnectionStats *s = this; s != nullptr; s = s->m_Aggregate)
+		s->m_Stat.read++;
+	if (stamp == nullptr)
+		return;
+	uint64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		Clock_t::now() - stamp->encoded).count();
+	size_t slot = typeSlot(stamp->type);
+	recordLatency(slot, latency);
+	if (m_Aggregate != nullptr)
+		m_Aggregate->recordLatency(slot, latency);
+}
+
+template <bool ENABLE_STATS>
+void
+ConnectionStats<ENABLE_STATS>::requestFailed()
+{
+	for (ConnectionStats *s = this; s != nullptr; s = s->m_Aggregate)
+		s->m_Stat.failed++;
+}
+
+template <bool ENABLE_STATS>
+void
+ConnectionStats<ENABLE_STATS>::requestTimedOut()
+{
+	for (ConnectionStats *s = this; s != nullptr; s = s->m_Aggregate)
+		s->m_Stat.timed_out++;
+}
+
+template <bool ENABLE_STATS>
+void
+ConnectionStats<ENABLE_STATS>::recordLatency(size_t slot, uint64_t latency)
+{
+	if (m_Latency[slot] == nullptr)
+		m_Latency[slot] = std::make_unique<LatencyHistogram>();
+	m_Latency[slot]->record(latency);
+}
+
+template <bool ENABLE_STATS>
+void
+ConnectionStats<ENABLE_STATS>::sendCalled(const struct iovec *iov,
+					  size_t iov_cnt, ssize_t rc)
+{
+	for (ConnectionStats *s = this; s != nullptr; s = s->m_Aggregate) {
+		s->m_Stat.send_calls++;
+		if (rc > 0)
+			s->m_Stat.bytes_sent += rc;
+	}
+	if (rc < 0)
+		return;
+	size_t requested = 0;
+	for (size_t i = 0; i < iov_cnt; ++i)
+		requested += iov[i].iov_len;
+	if ((size_t) rc >= requested)
+		return;
+	for (ConnectionStats *s = this; s != nullptr; s = s->m_Aggregate)
+		s->m_Stat.partial_writes++;
+}
+
+template <bool ENABLE_STATS>
+void
+ConnectionStats<ENABLE_STATS>::recvCalled(ssize_t rc)
+{
+	for (ConnectionStats *s = this; s != nullptr; s = s->m_Aggregate) {
+		s->m_Stat.recv_calls++;
+		if (rc > 0)
+			s->m_Stat.bytes_received += rc;
+	}
+}
+
+template <bool ENABLE_STATS>
+void
+ConnectionStats<ENABLE_STATS>::flushed(size_t requests,
+				       size_t ConnectionStat::*reason)
+{
+	for (ConnectionStats *s = this; s != nullptr; s = s->m_Aggregate) {
+		s->m_Stat.flushes++;
+		s->m_Stat.flushed_requests += requests;
+		if (reason != nullptr)
+			s->m_Stat.*reason += 1;
+	}
+}
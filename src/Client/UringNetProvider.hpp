@@ -0,0 +1,857 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "Connection.hpp"
+#include "Connector.hpp"
+#include "NetworkEngine.hpp"
+#include "../Utils/Timer.hpp"
+#include "../Utils/rlist.h"
+
+/* System headers above may bring builtin offsetof back. */
+#ifdef offsetof
+#undef offsetof
+#endif
+#define offsetof(type, member) ((size_t) &((type *)0)->member)
+
+template<class BUFFER, class NetProvider>
+class Connector;
+
+/**
+ * Minimal io_uring instance: submission and completion rings mapped
+ * into user space. liburing is not required, only kernel headers.
+ */
+class Uring {
+public:
+	Uring() = default;
+	~Uring();
+	Uring(const Uring& uring) = delete;
+	Uring& operator = (const Uring& uring) = delete;
+
+	int init(unsigned entries);
+	/** Return free SQE or nullptr if submission queue is full. */
+	struct io_uring_sqe *getSqe();
+	/**
+	 * Submit all pending SQEs and wait for at least @a min_complete
+	 * completions, but no longer than @a timeout milliseconds.
+	 * Return -1 and set errno to ETIME if timeout has expired.
+	 */
+	int enter(unsigned min_complete, int timeout);
+	/** Invoke @a handler for each ready CQE and consume them. */
+	template <class F>
+	unsigned reap(F&& handler);
+	/** Count of SQEs which have not been consumed by kernel yet. */
+	unsigned pending() const;
+
+private:
+	int m_Fd = -1;
+	void *m_SqRing = MAP_FAILED;
+	void *m_CqRing = MAP_FAILED;
+	size_t m_SqRingSize = 0;
+	size_t m_CqRingSize = 0;
+	struct io_uring_sqe *m_Sqes = (struct io_uring_sqe *) MAP_FAILED;
+	size_t m_SqesSize = 0;
+
+	unsigned *m_SqHead = nullptr;
+	unsigned *m_SqTail = nullptr;
+	unsigned *m_SqArray = nullptr;
+	unsigned m_SqMask = 0;
+	unsigned m_SqEntries = 0;
+	/** Local copy of tail: SQEs are published on enter(). */
+	unsigned m_SqLocalTail = 0;
+
+	unsigned *m_CqHead = nullptr;
+	unsigned *m_CqTail = nullptr;
+	unsigned m_CqMask = 0;
+	struct io_uring_cqe *m_Cqes = nullptr;
+};
+
+inline
+Uring::~Uring()
+{
+	if (m_Sqes != MAP_FAILED)
+		munmap(m_Sqes, m_SqesSize);
+	if (m_CqRing != MAP_FAILED && m_CqRing != m_SqRing)
+		munmap(m_CqRing, m_CqRingSize);
+	if (m_SqRing != MAP_FAILED)
+		munmap(m_SqRing, m_SqRingSize);
+	if (m_Fd >= 0)
+		::close(m_Fd);
+}
+
+inline int
+Uring::init(unsigned entries)
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	m_Fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (m_Fd < 0)
+		return -1;
+	if ((p.features & IORING_FEAT_EXT_ARG) == 0) {
+		LOG_ERROR("io_uring: IORING_FEAT_EXT_ARG is not supported, "
+			  "Linux 5.11 or newer is required");
+		errno = ENOTSUP;
+		return -1;
+	}
+	m_SqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	m_CqRingSize = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	if ((p.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+		m_SqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+		m_CqRingSize = m_SqRingSize;
+	}
+	m_SqRing = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING);
+	if (m_SqRing == MAP_FAILED)
+		return -1;
+	if ((p.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+		m_CqRing = m_SqRing;
+	} else {
+		m_CqRing = mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, m_Fd,
+				IORING_OFF_CQ_RING);
+		if (m_CqRing == MAP_FAILED)
+			return -1;
+	}
+	m_SqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+	m_Sqes = (struct io_uring_sqe *) mmap(nullptr, m_SqesSize,
+					     PROT_READ | PROT_WRITE,
+					     MAP_SHARED | MAP_POPULATE, m_Fd,
+					     IORING_OFF_SQES);
+	if (m_Sqes == MAP_FAILED)
+		return -1;
+
+	char *sq = (char *) m_SqRing;
+	m_SqHead = (unsigned *) (sq + p.sq_off.head);
+	m_SqTail = (unsigned *) (sq + p.sq_off.tail);
+	m_SqArray = (unsigned *) (sq + p.sq_off.array);
+	m_SqMask = *(unsigned *) (sq + p.sq_off.ring_mask);
+	m_SqEntries = p.sq_entries;
+	m_SqLocalTail = *m_SqTail;
+
+	char *cq = (char *) m_CqRing;
+	m_CqHead = (unsigned *) (cq + p.cq_off.head);
+	m_CqTail = (unsigned *) (cq + p.cq_off.tail);
+	m_CqMask = *(unsigned *) (cq + p.cq_off.ring_mask);
+	m_Cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+	return 0;
+}
+
+inline struct io_uring_sqe *
+Uring::getSqe()
+{
+	unsigned head = __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE);
+	if (m_SqLocalTail - head >= m_SqEntries)
+		return nullptr;
+	unsigned idx = m_SqLocalTail & m_SqMask;
+	m_SqArray[idx] = idx;
+	m_SqLocalTail++;
+	struct io_uring_sqe *sqe = &m_Sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+inline unsigned
+Uring::pending() const
+{
+	return m_SqLocalTail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE);
+}
+
+inline int
+Uring::enter(unsigned min_complete, int timeout)
+{
+	__atomic_store_n(m_SqTail, m_SqLocalTail, __ATOMIC_RELEASE);
+	if (min_complete == 0) {
+		int rc = syscall(__NR_io_uring_enter, m_Fd, pending(), 0, 0,
+				 nullptr, 0);
+		return rc < 0 ? -1 : 0;
+	}
+	struct __kernel_timespec ts;
+	ts.tv_sec = timeout / 1000;
+	ts.tv_nsec = (timeout % 1000) * 1000000L;
+	struct io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	arg.sigmask_sz = _NSIG / 8;
+	arg.ts = (uint64_t) (uintptr_t) &ts;
+	unsigned flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+	int rc = syscall(__NR_io_uring_enter, m_Fd, pending(), min_complete,
+			 flags, &arg, sizeof(arg));
+	return rc < 0 ? -1 : 0;
+}
+
+template <class F>
+unsigned
+Uring::reap(F&& handler)
+{
+	unsigned head = *m_CqHead;
+	unsigned tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+	unsigned count = tail - head;
+	for (; head != tail; ++head)
+		handler(m_Cqes[head & m_CqMask]);
+	__atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+	return count;
+}
+
+/**
+ * Network provider built on top of io_uring. Instead of polling sockets and
+ * then issuing a separate syscall per socket (as DefaultNetProvider does),
+ * recv/sendmsg are submitted straight to the ring, so one wait() costs a
+ * single io_uring_enter() in the common case.
+ * Each connection keeps one receive armed all the time: it is posted on a
+ * staging buffer owned by the provider rather than on the input buffer, so
+ * it may safely stay in flight between wait() calls. Received bytes are
+ * copied to the input buffer on completion and the receive is re-armed.
+ * It is cancelled only when the connection is closed.
+ */
+template<class BUFFER, class NETWORK>
+class UringNetProvider {
+public:
+	using NetProvider_t = UringNetProvider<BUFFER, NETWORK>;
+	using Conn_t = Connection<BUFFER, NetProvider_t >;
+	using Connector_t = Connector<BUFFER, NetProvider_t >;
+	UringNetProvider();
+	~UringNetProvider();
+	int connect(Conn_t &conn, const std::string_view& addr, unsigned port,
+		    size_t timeout);
+	/**
+	 * Start non-blocking connect. The receive of the greeting is armed
+	 * right away: it completes once the connection is established and
+	 * the greeting arrives, or fails with the error of connect.
+	 */
+	int connectAsync(Conn_t &conn, const std::string_view& addr,
+			 unsigned port, size_t timeout);
+	void close(Conn_t &conn);
+	/** Add to @m_ready_to_write */
+	void readyToSend(Conn_t &conn);
+	/**
+	 * Send queued data of connection with plain sendmsg(): sends are
+	 * never in flight outside of wait().
+	 */
+	void flush(Conn_t &conn);
+	/** Submit pending sends and reap completions of sends and receives. */
+	int wait(int timeout);
+
+	bool check(Conn_t &conn);
+	/**
+	 * Set bounds of adaptive receive buffer of connections established
+	 * after the call.
+	 */
+	void setRecvReserve(size_t min_size, size_t max_size);
+private:
+	static constexpr size_t DEFAULT_TIMEOUT = 100;
+	static constexpr unsigned URING_QUEUE_LEN = 1024;
+
+	enum UringOp {
+		OP_RECV = 0,
+		OP_SEND = 1,
+		OP_CANCEL = 2,
+		OP_MASK = 3
+	};
+
+	/** Per-connection state of requests submitted to the ring. */
+	struct UringConnection {
+		/** Set to nullptr once the connection is closed. */
+		Conn_t *conn;
+		struct msghdr send_msg;
+		/* Copy of connection's iovecs: they are reused by flush(). */
+		std::vector<struct iovec> send_iov;
+		/** Staging buffer the receive is armed on. */
+		std::unique_ptr<char[]> recv_buf;
+		size_t recv_capacity;
+		/** Bytes requested by the armed receive. */
+		size_t recv_len;
+		RecvReserve reserve;
+		std::chrono::steady_clock::time_point connect_deadline;
+		bool recv_inflight;
+		bool send_inflight;
+	};
+
+	UringConnection &addConnection(Conn_t &conn);
+	struct io_uring_sqe *getSqe();
+	void prepRecv(UringConnection &uc);
+	void prepSend(UringConnection &uc);
+	void prepCancel(UringConnection &uc, UringOp op);
+	void complete(const struct io_uring_cqe &cqe);
+	void completeRecv(UringConnection &uc, int res);
+	/** Process the greeting received so far. Return false on failure. */
+	bool handshake(UringConnection &uc);
+	/** Fail timed out connects, return timeout shortened to next one. */
+	int expireConnects(int timeout);
+	/** Release state of closed connection once its receive is done. */
+	void forget(UringConnection &uc);
+	void cancelSends();
+	void closeFailed();
+
+	/** <socket : connection> map. */
+	std::unordered_map<int, std::unique_ptr<UringConnection>> m_Connections;
+	/** Closed connections which wait for cancel of their receive. */
+	std::vector<std::unique_ptr<UringConnection>> m_Closed;
+	/** Connections failed during wait(): closed once it is done. */
+	std::vector<Conn_t *> m_Failed;
+	/** Template of receive reservation for new connections. */
+	RecvReserve m_RecvReserve;
+	rlist m_ready_to_write;
+	Uring m_Ring;
+	/** Count of submitted send/recv requests which are not completed. */
+	size_t m_InFlight;
+	/** Count of submitted sends which are not completed. */
+	size_t m_Sending;
+	/** Count of receive requests completed during current wait(). */
+	size_t m_Received;
+	/** Count of connections waiting for the greeting. */
+	size_t m_Connecting;
+};
+
+template<class BUFFER, class NETWORK>
+UringNetProvider<BUFFER, NETWORK>::UringNetProvider() :
+	m_InFlight(0), m_Sending(0), m_Received(0), m_Connecting(0)
+{
+	if (m_Ring.init(URING_QUEUE_LEN) != 0) {
+		LOG_ERROR("Failed to initialize io_uring: ", strerror(errno));
+		abort();
+	}
+	rlist_create(&m_ready_to_write);
+}
+
+template<class BUFFER, class NETWORK>
+UringNetProvider<BUFFER, NETWORK>::~UringNetProvider()
+{
+	/* Kernel may still write to staging buffers of closed connections. */
+	while (! m_Closed.empty()) {
+		if (m_Ring.enter(1, DEFAULT_TIMEOUT) != 0 && errno != ETIME &&
+		    errno != EINTR) {
+			LOG_ERROR("io_uring_enter() failed: ", strerror(errno));
+			abort();
+		}
+		m_Ring.reap([this](const struct io_uring_cqe &cqe) {
+			complete(cqe);
+		});
+	}
+	assert(m_Sending == 0);
+	assert(rlist_empty(&m_ready_to_write));
+}
+
+template<class BUFFER, class NETWORK>
+typename UringNetProvider<BUFFER, NETWORK>::UringConnection &
+UringNetProvider<BUFFER, NETWORK>::addConnection(Conn_t &conn)
+{
+	std::unique_ptr<UringConnection> &uc = m_Connections[conn.socket];
+	assert(uc == nullptr);
+	uc = std::make_unique<UringConnection>();
+	uc->conn = &conn;
+	uc->reserve = m_RecvReserve;
+	return *uc;
+}
+
+template<class BUFFER, class NETWORK>
+int
+UringNetProvider<BUFFER, NETWORK>::connect(Conn_t &conn,
+					   const std::string_view& addr,
+					   unsigned port, size_t timeout)
+{
+	int socket = -1;
+	socket = port == 0 ? NETWORK::connectUNIX(addr) :
+			NETWORK::connectINET(addr, port, timeout);
+	if (socket < 0) {
+		conn.setError(std::string("Failed to establish connection to ") +
+			      std::string(addr));
+		return -1;
+	}
+	LOG_DEBUG("Connected to ", addr, ", socket is ", socket);
+	/* Receive and decode greetings. */
+	size_t iov_cnt = 0;
+	struct iovec *iov =
+		inBufferToIOV(conn, Iproto::GREETING_SIZE, &iov_cnt);
+	LOG_DEBUG("Receiving greetings...");
+	int read_bytes = NETWORK::recvall(socket, iov, iov_cnt, false);
+	if (read_bytes < 0) {
+		conn.setError(std::string("Failed to receive greetings: ") +
+			      strerror(errno));
+		::close(socket);
+		return -1;
+	}
+	LOG_DEBUG("Greetings are received, read bytes ", read_bytes);
+	if (decodeGreeting(conn) != 0) {
+		conn.setError(std::string("Failed to decode greetings"));
+		::close(socket);
+		return -1;
+	}
+	LOG_DEBUG("Greetings are decoded");
+	conn.socket = socket;
+	prepRecv(addConnection(conn));
+	return 0;
+}
+
+template<class BUFFER, class NETWORK>
+int
+UringNetProvider<BUFFER, NETWORK>::connectAsync(Conn_t &conn,
+						const std::string_view& addr,
+						unsigned port, size_t timeout)
+{
+	int socket = port == 0 ? NETWORK::connectUNIX(addr) :
+				 NETWORK::connectINETAsync(addr, port);
+	if (socket < 0) {
+		conn.setError(std::string("Failed to establish connection to ") +
+			      std::string(addr));
+		return -1;
+	}
+	LOG_DEBUG("Connecting to ", addr, ", socket is ", socket);
+	conn.socket = socket;
+	conn.status.is_connecting = true;
+	m_Connecting++;
+	UringConnection &uc = addConnection(conn);
+	uc.connect_deadline = std::chrono::steady_clock::now() +
+			      std::chrono::seconds(timeout);
+	prepRecv(uc);
+	return 0;
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::close(Conn_t &conn)
+{
+	auto itr = m_Connections.find(conn.socket);
+	if (itr != m_Connections.end()) {
+		UringConnection &uc = *itr->second;
+		assert(! uc.send_inflight);
+		uc.conn = nullptr;
+		if (uc.recv_inflight) {
+			prepCancel(uc, OP_RECV);
+			/*
+			 * Submit the receive (if it is still queued) before
+			 * its descriptor is closed and may be reused.
+			 */
+			if (m_Ring.enter(0, 0) != 0) {
+				LOG_ERROR("io_uring_enter() failed: ",
+					  strerror(errno));
+				abort();
+			}
+			m_Closed.push_back(std::move(itr->second));
+		}
+		m_Connections.erase(itr);
+	}
+	NETWORK::close(conn.socket);
+	conn.socket = -1;
+	if (conn.status.is_connecting) {
+		conn.status.is_connecting = false;
+		m_Connecting--;
+	}
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::forget(UringConnection &uc)
+{
+	auto itr = std::find_if(m_Closed.begin(), m_Closed.end(),
+				[&uc](const auto &c) { return c.get() == &uc; });
+	assert(itr != m_Closed.end());
+	std::swap(*itr, m_Closed.back());
+	m_Closed.pop_back();
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::readyToSend(Conn_t &conn)
+{
+	if (conn.status.is_ready_to_send) {
+		assert(! rlist_empty(&conn.m_in_write));
+		return;
+	}
+	rlist_add_tail(&m_ready_to_write, &conn.m_in_write);
+	conn.status.is_ready_to_send = true;
+}
+
+template<class BUFFER, class NETWORK>
+struct io_uring_sqe *
+UringNetProvider<BUFFER, NETWORK>::getSqe()
+{
+	struct io_uring_sqe *sqe = m_Ring.getSqe();
+	if (sqe != nullptr)
+		return sqe;
+	/* Submission queue is full: flush it without waiting. */
+	if (m_Ring.enter(0, 0) != 0) {
+		LOG_ERROR("io_uring_enter() failed: ", strerror(errno));
+		abort();
+	}
+	sqe = m_Ring.getSqe();
+	assert(sqe != nullptr);
+	return sqe;
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::prepRecv(UringConnection &uc)
+{
+	assert(! uc.recv_inflight);
+	if (uc.recv_capacity != uc.reserve.size) {
+		uc.recv_buf.reset(new char[uc.reserve.size]);
+		uc.recv_capacity = uc.reserve.size;
+	}
+	uc.recv_len = uc.recv_capacity;
+	/* Nothing but the greeting is read before the handshake is over. */
+	if (uc.conn->status.is_connecting)
+		uc.recv_len = std::min(uc.recv_len, greetingBytesLeft(*uc.conn));
+
+	struct io_uring_sqe *sqe = getSqe();
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = uc.conn->socket;
+	sqe->addr = (uint64_t) (uintptr_t) uc.recv_buf.get();
+	sqe->len = uc.recv_len;
+	sqe->user_data = (uint64_t) (uintptr_t) &uc | OP_RECV;
+	uc.recv_inflight = true;
+	m_InFlight++;
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::prepSend(UringConnection &uc)
+{
+	assert(! uc.send_inflight);
+	size_t iov_cnt = 0;
+	struct iovec *iov = outBufferToIOV(*uc.conn, &iov_cnt);
+	uc.send_iov.assign(iov, iov + iov_cnt);
+	memset(&uc.send_msg, 0, sizeof(uc.send_msg));
+	uc.send_msg.msg_iov = uc.send_iov.data();
+	uc.send_msg.msg_iovlen = iov_cnt;
+
+	struct io_uring_sqe *sqe = getSqe();
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = uc.conn->socket;
+	sqe->addr = (uint64_t) (uintptr_t) &uc.send_msg;
+	sqe->len = 1;
+	sqe->msg_flags = MSG_NOSIGNAL;
+	sqe->user_data = (uint64_t) (uintptr_t) &uc | OP_SEND;
+	uc.send_inflight = true;
+	m_InFlight++;
+	m_Sending++;
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::prepCancel(UringConnection &uc, UringOp op)
+{
+	struct io_uring_sqe *sqe = getSqe();
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = (uint64_t) (uintptr_t) &uc | op;
+	sqe->user_data = (uint64_t) (uintptr_t) &uc | OP_CANCEL;
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::complete(const struct io_uring_cqe &cqe)
+{
+	UringOp op = (UringOp) (cqe.user_data & OP_MASK);
+	/* Connection may be already released: don't touch it. */
+	if (op == OP_CANCEL)
+		return;
+	UringConnection &uc =
+		*(UringConnection *) (uintptr_t) (cqe.user_data & ~(uint64_t) OP_MASK);
+	assert(m_InFlight > 0);
+	m_InFlight--;
+	if (op == OP_RECV) {
+		completeRecv(uc, cqe.res);
+		return;
+	}
+	assert(op == OP_SEND);
+	assert(m_Sending > 0);
+	m_Sending--;
+	uc.send_inflight = false;
+	Conn_t &conn = *uc.conn;
+	statSendCall(conn, uc.send_iov.data(), uc.send_iov.size(), cqe.res);
+	if (cqe.res >= 0) {
+		hasSentBytes(conn, cqe.res);
+		LOG_DEBUG("send ", cqe.res, " bytes to the ", conn.socket, " socket");
+		return;
+	}
+	if (cqe.res == -ECANCELED)
+		return;
+	conn.setError(std::string("Failed to send request: ") +
+		      strerror(-cqe.res));
+	m_Failed.push_back(&conn);
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::completeRecv(UringConnection &uc, int res)
+{
+	uc.recv_inflight = false;
+	if (uc.conn == nullptr) {
+		forget(uc);
+		return;
+	}
+	Conn_t &conn = *uc.conn;
+	statRecvCall(conn, res);
+	if (res <= 0) {
+		if (res == 0) {
+			conn.setError("Connection is closed by peer");
+		} else if (conn.status.is_connecting) {
+			conn.setError(std::string("Failed to establish "
+						  "connection: ") +
+				      strerror(-res));
+		} else {
+			conn.setError(std::string("Failed to receive response: ") +
+				      strerror(-res));
+		}
+		m_Failed.push_back(&conn);
+		return;
+	}
+	size_t read_bytes = res;
+	LOG_DEBUG("read ", read_bytes, " bytes from ", conn.socket, " socket");
+	m_Received++;
+	uc.reserve.update(read_bytes, uc.recv_len);
+	size_t iov_cnt = 0;
+	struct iovec *iov = inBufferToIOV(conn, read_bytes, &iov_cnt);
+	const char *data = uc.recv_buf.get();
+	for (size_t i = 0; i < iov_cnt; ++i) {
+		memcpy(iov[i].iov_base, data, iov[i].iov_len);
+		data += iov[i].iov_len;
+	}
+	assert(data == uc.recv_buf.get() + read_bytes);
+	if (conn.status.is_connecting) {
+		if (! handshake(uc))
+			return;
+	} else if (! conn.status.is_ready_to_decode) {
+		conn.readyToDecode();
+	}
+	prepRecv(uc);
+}
+
+template<class BUFFER, class NETWORK>
+bool
+UringNetProvider<BUFFER, NETWORK>::handshake(UringConnection &uc)
+{
+	Conn_t &conn = *uc.conn;
+	if (greetingBytesLeft(conn) > 0)
+		return true;
+	if (decodeGreeting(conn) != 0) {
+		conn.setError(std::string("Failed to decode greetings"));
+		m_Failed.push_back(&conn);
+		return false;
+	}
+	LOG_DEBUG("Greetings are decoded");
+	conn.status.is_connecting = false;
+	m_Connecting--;
+	return true;
+}
+
+template<class BUFFER, class NETWORK>
+int
+UringNetProvider<BUFFER, NETWORK>::expireConnects(int timeout)
+{
+	auto now = std::chrono::steady_clock::now();
+	auto next = std::chrono::steady_clock::time_point::max();
+	for (auto &c : m_Connections) {
+		UringConnection &uc = *c.second;
+		if (! uc.conn->status.is_connecting ||
+		    uc.conn->status.is_failed)
+			continue;
+		if (uc.connect_deadline <= now) {
+			uc.conn->setError("Connect is timed out");
+			m_Failed.push_back(uc.conn);
+		} else {
+			next = std::min(next, uc.connect_deadline);
+		}
+	}
+	if (next == std::chrono::steady_clock::time_point::max())
+		return timeout;
+	using namespace std::chrono;
+	int left = (int) ceil<milliseconds>(next - now).count();
+	return std::min(timeout, std::max(left, 1));
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::cancelSends()
+{
+	if (m_Sending == 0)
+		return;
+	for (auto &c : m_Connections) {
+		UringConnection &uc = *c.second;
+		if (uc.send_inflight)
+			prepCancel(uc, OP_SEND);
+	}
+	while (m_Sending > 0) {
+		if (m_Ring.enter(1, DEFAULT_TIMEOUT) != 0 && errno != ETIME &&
+		    errno != EINTR) {
+			LOG_ERROR("io_uring_enter() failed: ", strerror(errno));
+			abort();
+		}
+		m_Ring.reap([this](const struct io_uring_cqe &cqe) {
+			complete(cqe);
+		});
+	}
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::closeFailed()
+{
+	for (Conn_t *failed : m_Failed) {
+		if (failed->socket >= 0)
+			close(*failed);
+	}
+	m_Failed.clear();
+}
+
+template<class BUFFER, class NETWORK>
+int
+UringNetProvider<BUFFER, NETWORK>::wait(int timeout)
+{
+	assert(timeout >= 0);
+	assert(m_Sending == 0);
+	if (timeout == 0)
+		timeout = DEFAULT_TIMEOUT;
+	LOG_DEBUG("Network engine wait for ", timeout, " milliseconds");
+	if (m_Connecting != 0)
+		timeout = expireConnects(timeout);
+	Timer timer{timeout};
+	timer.start();
+	/* Queue pending requests. Receives are armed already. */
+	size_t send_cnt = 0;
+	Conn_t *conn;
+	rlist_foreach_entry(conn, &m_ready_to_write, m_in_write) {
+		auto uc = m_Connections.find(conn->socket);
+		if (uc == m_Connections.end() || conn->status.is_failed ||
+		    conn->status.is_connecting || ! hasDataToSend(*conn))
+			continue;
+		prepSend(*uc->second);
+		send_cnt++;
+	}
+	if (m_InFlight == 0) {
+		closeFailed();
+		return 0;
+	}
+	/*
+	 * Sends usually complete right on submission, so wait for all of
+	 * them plus at least one receive: in steady state it is the only
+	 * io_uring_enter() call per wait().
+	 */
+	m_Received = 0;
+	size_t recv_cnt = m_InFlight - send_cnt;
+	unsigned min_complete = send_cnt + (recv_cnt > 0 ? 1 : 0);
+	/* Report failed connection without sleeping. */
+	if (! m_Failed.empty())
+		min_complete = 0;
+	int rc = 0;
+	do {
+		int left = std::max(timeout - timer.elapsed(), 0);
+		if (m_Ring.enter(min_complete, left) != 0) {
+			if (errno == ETIME)
+				break;
+			if (errno != EINTR) {
+				LOG_ERROR("io_uring_enter() failed: ",
+					  strerror(errno));
+				rc = -1;
+				break;
+			}
+		}
+		m_Ring.reap([this](const struct io_uring_cqe &cqe) {
+			complete(cqe);
+		});
+		min_complete = 1;
+	} while (m_Received == 0 && m_InFlight > 0 && m_Failed.empty() &&
+		 !timer.isExpired());
+	cancelSends();
+	if (m_Connecting != 0)
+		expireConnects(0);
+	closeFailed();
+	return rc;
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::flush(Conn_t &conn)
+{
+	assert(m_Sending == 0);
+	if (conn.status.is_connecting)
+		return;
+	while (hasDataToSend(conn)) {
+		size_t iov_cnt = 0;
+		struct iovec *iov = outBufferToIOV(conn, &iov_cnt);
+		int rc = NETWORK::send(conn.socket, iov, iov_cnt);
+		statSendCall(conn, iov, iov_cnt, rc);
+		if (rc >= 0) {
+			hasSentBytes(conn, rc);
+			continue;
+		}
+		/* Rest of data is sent by the next wait(). */
+		if (netWouldBlock(errno))
+			return;
+		conn.setError(std::string("Failed to send request: ") +
+			      strerror(errno));
+		close(conn);
+		return;
+	}
+}
+
+template<class BUFFER, class NETWORK>
+void
+UringNetProvider<BUFFER, NETWORK>::setRecvReserve(size_t min_size,
+						  size_t max_size)
+{
+	assert(min_size > 0 && min_size <= max_size);
+	m_RecvReserve = RecvReserve(min_size, max_size);
+}
+
+template<class BUFFER, class NETWORK>
+bool
+UringNetProvider<BUFFER, NETWORK>::check(Conn_t &connection)
+{
+	int error = 0;
+	socklen_t len = sizeof(error);
+	int rc = getsockopt(connection.socket, SOL_SOCKET, SO_ERROR, &error, &len);
+	if (rc != 0) {
+		connection.setError(strerror(rc));
+		return false;
+	}
+	if (error != 0) {
+		connection.setError(strerror(error));
+		return false;
+	}
+	return true;
+}
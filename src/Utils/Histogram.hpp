@@ -0,0 +1,156 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace tnt {
+
+/**
+ * Histogram of non-negative integer values (e.g. latencies in nanoseconds)
+ * in the spirit of HdrHistogram. Values below 2^SUB_BITS are counted
+ * exactly. Greater values fall into log-linear buckets: each power of two
+ * range is split into 2^(SUB_BITS - 1) equal sub-buckets, so relative error
+ * of any reported value doesn't exceed 2^(1 - SUB_BITS). Values of
+ * MAX_BITS bits and more are accounted in the last bucket.
+ * Recording is a couple of arithmetic operations and an increment; the
+ * histogram has fixed size and never allocates memory.
+ */
+template <size_t SUB_BITS = 5, size_t MAX_BITS = 40>
+class Histogram {
+	static_assert(SUB_BITS >= 1 && SUB_BITS < MAX_BITS && MAX_BITS <= 64,
+		      "Wrong histogram precision/range");
+public:
+	static constexpr size_t SUB_BUCKET_HALF = size_t{1} << (SUB_BITS - 1);
+	/* Log-linear buckets and one more for too big values. */
+	static constexpr size_t BUCKET_COUNT =
+		(MAX_BITS - SUB_BITS + 2) * SUB_BUCKET_HALF + 1;
+
+	/** Account one more @a value. */
+	void record(uint64_t value);
+	/** Add all values accounted by @a other histogram. */
+	void merge(const Histogram &other);
+	void reset() { *this = Histogram(); }
+
+	/** Count of accounted values. */
+	uint64_t count() const { return m_Count; }
+	/** Exact minimal, maximal and average values; 0 if empty. */
+	uint64_t min() const { return m_Count != 0 ? m_Min : 0; }
+	uint64_t max() const { return m_Max; }
+	uint64_t mean() const { return m_Count != 0 ? m_Sum / m_Count : 0; }
+	/**
+	 * Value which is not less than @a percent percents of accounted
+	 * values (approximated by upper bound of the bucket). 0 if empty.
+	 */
+	uint64_t percentile(double percent) const;
+
+	static size_t bucketIndex(uint64_t value);
+	/** The greatest value which falls into the bucket @a index. */
+	static uint64_t bucketUpperBound(size_t index);
+private:
+	uint64_t m_Buckets[BUCKET_COUNT] = {};
+	uint64_t m_Count = 0;
+	uint64_t m_Sum = 0;
+	uint64_t m_Min = UINT64_MAX;
+	uint64_t m_Max = 0;
+};
+
+template <size_t SUB_BITS, size_t MAX_BITS>
+size_t
+Histogram<SUB_BITS, MAX_BITS>::bucketIndex(uint64_t value)
+{
+	if (value < (uint64_t{1} << SUB_BITS))
+		return value;
+	size_t msb = 63 - __builtin_clzll(value);
+	if (msb >= MAX_BITS)
+		return BUCKET_COUNT - 1;
+	size_t shift = msb - SUB_BITS + 1;
+	return shift * SUB_BUCKET_HALF + (value >> shift);
+}
+
+template <size_t SUB_BITS, size_t MAX_BITS>
+uint64_t
+Histogram<SUB_BITS, MAX_BITS>::bucketUpperBound(size_t index)
+{
+	assert(index < BUCKET_COUNT);
+	if (index == BUCKET_COUNT - 1)
+		return UINT64_MAX;
+	if (index < (size_t{1} << SUB_BITS))
+		return index;
+	size_t shift = index / SUB_BUCKET_HALF - 1;
+	uint64_t sub = index % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+	return ((sub + 1) << shift) - 1;
+}
+
+template <size_t SUB_BITS, size_t MAX_BITS>
+void
+Histogram<SUB_BITS, MAX_BITS>::record(uint64_t value)
+{
+	m_Buckets[bucketIndex(value)]++;
+	m_Count++;
+	m_Sum += value;
+	m_Min = std::min(m_Min, value);
+	m_Max = std::max(m_Max, value);
+}
+
+template <size_t SUB_BITS, size_t MAX_BITS>
+void
+Histogram<SUB_BITS, MAX_BITS>::merge(const Histogram &other)
+{
+	for (size_t i = 0; i < BUCKET_COUNT; ++i)
+		m_Buckets[i] += other.m_Buckets[i];
+	m_Count += other.m_Count;
+	m_Sum += other.m_Sum;
+	m_Min = std::min(m_Min, other.m_Min);
+	m_Max = std::max(m_Max, other.m_Max);
+}
+
+template <size_t SUB_BITS, size_t MAX_BITS>
+uint64_t
+Histogram<SUB_BITS, MAX_BITS>::percentile(double percent) const
+{
+	if (m_Count == 0)
+		return 0;
+	uint64_t rank = (uint64_t) (percent / 100 * m_Count + 0.5);
+	rank = std::clamp<uint64_t>(rank, 1, m_Count);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+		seen += m_Buckets[i];
+		if (seen >= rank)
+			return std::min(bucketUpperBound(i), m_Max);
+	}
+	return m_Max;
+}
+
+} // namespace tnt
@@ -0,0 +1,171 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace tnt {
+
+/**
+ * Map of limited capacity which evicts the least recently used entry on
+ * overflow. Lookup, insertion and eviction cost O(1).
+ * Evicted entry is passed to the callback given to insert(): values may
+ * own external resources which have to be released.
+ */
+template <class Key, class Value, class Hash = std::hash<Key>>
+class LruCache {
+public:
+	explicit LruCache(size_t capacity = 0) : m_Capacity(capacity) {}
+	LruCache(const LruCache&) = delete;
+	LruCache& operator=(const LruCache&) = delete;
+
+	size_t size() const { return m_Entries.size(); }
+	size_t capacity() const { return m_Capacity; }
+	/**
+	 * Find value by @a key and mark it as the most recently used.
+	 * Return nullptr if there's no such key.
+	 */
+	Value *find(const Key &key);
+	/** Same as find() but doesn't affect eviction order. */
+	Value *peek(const Key &key);
+	/**
+	 * Insert (or replace) value and mark it as the most recently used.
+	 * If the cache overflows, the least recently used entries are
+	 * passed to @a on_evict(key, value) and removed.
+	 */
+	template <class F>
+	Value &insert(const Key &key, Value value, F &&on_evict);
+	/** Return false if there's no such key. */
+	bool erase(const Key &key);
+	/** Change capacity evicting entries which don't fit anymore. */
+	template <class F>
+	void setCapacity(size_t capacity, F &&on_evict);
+	void clear();
+
+private:
+	using Entry_t = std::pair<Key, Value>;
+	using List_t = std::list<Entry_t>;
+
+	template <class F>
+	void shrink(F &&on_evict);
+
+	size_t m_Capacity;
+	/** The most recently used entry is the first. */
+	List_t m_Entries;
+	std::unordered_map<Key, typename List_t::iterator, Hash> m_Index;
+};
+
+template <class Key, class Value, class Hash>
+Value *
+LruCache<Key, Value, Hash>::find(const Key &key)
+{
+	auto itr = m_Index.find(key);
+	if (itr == m_Index.end())
+		return nullptr;
+	m_Entries.splice(m_Entries.begin(), m_Entries, itr->second);
+	return &itr->second->second;
+}
+
+template <class Key, class Value, class Hash>
+Value *
+LruCache<Key, Value, Hash>::peek(const Key &key)
+{
+	auto itr = m_Index.find(key);
+	if (itr == m_Index.end())
+		return nullptr;
+	return &itr->second->second;
+}
+
+template <class Key, class Value, class Hash>
+template <class F>
+Value &
+LruCache<Key, Value, Hash>::insert(const Key &key, Value value, F &&on_evict)
+{
+	assert(m_Capacity > 0);
+	auto itr = m_Index.find(key);
+	if (itr != m_Index.end()) {
+		m_Entries.splice(m_Entries.begin(), m_Entries, itr->second);
+		itr->second->second = std::move(value);
+		return itr->second->second;
+	}
+	m_Entries.emplace_front(key, std::move(value));
+	m_Index.emplace(key, m_Entries.begin());
+	shrink(on_evict);
+	return m_Entries.front().second;
+}
+
+template <class Key, class Value, class Hash>
+bool
+LruCache<Key, Value, Hash>::erase(const Key &key)
+{
+	auto itr = m_Index.find(key);
+	if (itr == m_Index.end())
+		return false;
+	m_Entries.erase(itr->second);
+	m_Index.erase(itr);
+	return true;
+}
+
+template <class Key, class Value, class Hash>
+template <class F>
+void
+LruCache<Key, Value, Hash>::setCapacity(size_t capacity, F &&on_evict)
+{
+	m_Capacity = capacity;
+	shrink(on_evict);
+}
+
+template <class Key, class Value, class Hash>
+void
+LruCache<Key, Value, Hash>::clear()
+{
+	m_Index.clear();
+	m_Entries.clear();
+}
+
+template <class Key, class Value, class Hash>
+template <class F>
+void
+LruCache<Key, Value, Hash>::shrink(F &&on_evict)
+{
+	while (m_Entries.size() > m_Capacity) {
+		Entry_t &victim = m_Entries.back();
+		on_evict(victim.first, victim.second);
+		m_Index.erase(victim.first);
+		m_Entries.pop_back();
+	}
+}
+
+} // namespace tnt
@@ -123,9 +123,13 @@ public:
 			delete tmp;
 		}
 	}
+	/**
+	 * Default instance is thread-local: instance is not thread-safe, so
+	 * each thread allocates (and must free) blocks in its own pool.
+	 */
 	static MempoolInstance& defaultInstance()
 	{
-		static MempoolInstance instance;
+		static thread_local MempoolInstance instance;
 		return instance;
 	}
 	char *allocate()
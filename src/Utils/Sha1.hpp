@@ -0,0 +1,167 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * SHA-1 (FIPS 180-4) message digest. It is not secure anymore and is here
+ * only because Tarantool's chap-sha1 authentication is built on it.
+ */
+
+namespace sha1 {
+
+constexpr size_t DIGEST_SIZE = 20;
+constexpr size_t BLOCK_SIZE = 64;
+
+class Context {
+public:
+	Context() { reset(); }
+	void reset();
+	void update(const void *data, size_t size);
+	/** Write digest of all the data to @a digest and reset context. */
+	void finish(uint8_t digest[DIGEST_SIZE]);
+private:
+	void processBlock(const uint8_t *block);
+
+	uint32_t m_State[5];
+	uint64_t m_Size;
+	uint8_t m_Block[BLOCK_SIZE];
+};
+
+inline uint32_t
+rol(uint32_t x, unsigned n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+inline void
+Context::reset()
+{
+	m_State[0] = 0x67452301;
+	m_State[1] = 0xEFCDAB89;
+	m_State[2] = 0x98BADCFE;
+	m_State[3] = 0x10325476;
+	m_State[4] = 0xC3D2E1F0;
+	m_Size = 0;
+}
+
+inline void
+Context::processBlock(const uint8_t *block)
+{
+	uint32_t w[80];
+	for (size_t i = 0; i < 16; ++i)
+		w[i] = (uint32_t) block[i * 4] << 24 |
+		       (uint32_t) block[i * 4 + 1] << 16 |
+		       (uint32_t) block[i * 4 + 2] << 8 |
+		       (uint32_t) block[i * 4 + 3];
+	for (size_t i = 16; i < 80; ++i)
+		w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+	uint32_t a = m_State[0], b = m_State[1], c = m_State[2];
+	uint32_t d = m_State[3], e = m_State[4];
+	for (size_t i = 0; i < 80; ++i) {
+		uint32_t f, k;
+		if (i < 20) {
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+		uint32_t t = rol(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = rol(b, 30);
+		b = a;
+		a = t;
+	}
+	m_State[0] += a;
+	m_State[1] += b;
+	m_State[2] += c;
+	m_State[3] += d;
+	m_State[4] += e;
+}
+
+inline void
+Context::update(const void *data, size_t size)
+{
+	const uint8_t *p = (const uint8_t *) data;
+	size_t used = m_Size % BLOCK_SIZE;
+	m_Size += size;
+	if (used != 0) {
+		size_t n = BLOCK_SIZE - used < size ? BLOCK_SIZE - used : size;
+		memcpy(m_Block + used, p, n);
+		p += n;
+		size -= n;
+		if (used + n < BLOCK_SIZE)
+			return;
+		processBlock(m_Block);
+	}
+	for (; size >= BLOCK_SIZE; p += BLOCK_SIZE, size -= BLOCK_SIZE)
+		processBlock(p);
+	memcpy(m_Block, p, size);
+}
+
+inline void
+Context::finish(uint8_t digest[DIGEST_SIZE])
+{
+	uint64_t bits = m_Size * 8;
+	uint8_t pad[BLOCK_SIZE + 8] = {0x80};
+	size_t used = m_Size % BLOCK_SIZE;
+	/* Pad to 56 bytes modulo block size, then append size in bits. */
+	size_t pad_size = used < BLOCK_SIZE - 8 ? BLOCK_SIZE - 8 - used :
+			  2 * BLOCK_SIZE - 8 - used;
+	for (size_t i = 0; i < 8; ++i)
+		pad[pad_size + i] = (uint8_t) (bits >> (56 - 8 * i));
+	update(pad, pad_size + 8);
+	for (size_t i = 0; i < DIGEST_SIZE; ++i)
+		digest[i] = (uint8_t) (m_State[i / 4] >> (24 - 8 * (i % 4)));
+	reset();
+}
+
+/** Calculate digest of @a size bytes of @a data. */
+inline void
+digest(const void *data, size_t size, uint8_t out[DIGEST_SIZE])
+{
+	Context ctx;
+	ctx.update(data, size);
+	ctx.finish(out);
+}
+
+} // namespace sha1 {
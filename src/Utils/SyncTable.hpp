@@ -0,0 +1,290 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Mempool.hpp"
+
+namespace tnt {
+
+/**
+ * SyncTable is a map from sequentially issued keys (request syncs) to
+ * values. Keys are expected to be dense: most of them are inserted and
+ * removed in nearly ascending order. Such keys are stored in a sliding
+ * window - a power-of-two array of pointers indexed by key - base - while
+ * values themselves are allocated from a mempool of the table. So the
+ * window costs a pointer per key however large values are, values never
+ * move (pointers to them stay valid until removal) and, once the pool has
+ * warmed up, lookup, insertion and removal are O(1) and do not allocate
+ * memory unless the window has to grow.
+ * The window slides forward as values at its head are taken. Stragglers
+ * (keys behind the head of the window or too far ahead of it) are kept
+ * in a fallback hash map.
+ */
+template <class T, size_t MAX_WINDOW = 1024 * 1024>
+class SyncTable {
+	static_assert((MAX_WINDOW & (MAX_WINDOW - 1)) == 0,
+		      "Window size limit must be power of 2");
+public:
+	SyncTable() = default;
+	~SyncTable();
+	SyncTable(const SyncTable &) = delete;
+	SyncTable &operator=(const SyncTable &) = delete;
+
+	/** Insert value with given key unless the key is already present. */
+	void insert(size_t key, T &&value);
+	/**
+	 * Construct value with given key in place. Return pointer to it or
+	 * nullptr if the key is already present.
+	 */
+	template <class... ARGS>
+	T *emplace(size_t key, ARGS &&...args);
+	/** Return pointer to the value of given key or nullptr. */
+	T *find(size_t key);
+	/** Remove value of given key and return it. */
+	std::optional<T> take(size_t key);
+	/** Destroy value of given key. Return false if there's no such key. */
+	bool erase(size_t key);
+	/**
+	 * Invoke @a f(key, value) for each value. @a f must not insert or
+	 * remove values.
+	 */
+	template <class F>
+	void forEach(F &&f);
+	/** Count of values in the table. */
+	size_t size() const { return m_Count + m_Stragglers.size(); }
+
+	static constexpr size_t MIN_WINDOW = 16;
+private:
+	static constexpr size_t BLOCK_SIZE = std::max(sizeof(T), sizeof(void *));
+	/** Slab of values is 32 blocks, e.g. 34Kb for decoded responses. */
+	using Pool_t = MempoolInstance<BLOCK_SIZE, 32>;
+
+	T **slot(size_t key);
+	/** Detach the value of given key from the table. */
+	T *unlink(size_t key);
+	template <class... ARGS>
+	T *create(ARGS &&...args);
+	void destroy(T *value);
+	void grow(size_t span);
+	void advance();
+
+	Pool_t m_Pool;
+	std::vector<T *> m_Slots;
+	/** Key corresponding to the head of the window. */
+	size_t m_Base = 0;
+	/** Count of values in the window. */
+	size_t m_Count = 0;
+	std::unordered_map<size_t, T *> m_Stragglers;
+};
+
+template <class T, size_t MAX_WINDOW>
+SyncTable<T, MAX_WINDOW>::~SyncTable()
+{
+	for (T *value : m_Slots) {
+		if (value != nullptr)
+			destroy(value);
+	}
+	for (auto &straggler : m_Stragglers)
+		destroy(straggler.second);
+}
+
+template <class T, size_t MAX_WINDOW>
+template <class... ARGS>
+T *
+SyncTable<T, MAX_WINDOW>::create(ARGS &&...args)
+{
+	static_assert(Pool_t::BLOCK_ALIGN >= alignof(T), "Must be!");
+	return new (m_Pool.allocate()) T(std::forward<ARGS>(args)...);
+}
+
+template <class T, size_t MAX_WINDOW>
+void
+SyncTable<T, MAX_WINDOW>::destroy(T *value)
+{
+	value->~T();
+	m_Pool.deallocate(reinterpret_cast<char *>(value));
+}
+
+template <class T, size_t MAX_WINDOW>
+T **
+SyncTable<T, MAX_WINDOW>::slot(size_t key)
+{
+	if (key < m_Base || key - m_Base >= m_Slots.size())
+		return nullptr;
+	return &m_Slots[key & (m_Slots.size() - 1)];
+}
+
+template <class T, size_t MAX_WINDOW>
+void
+SyncTable<T, MAX_WINDOW>::grow(size_t span)
+{
+	assert(span <= MAX_WINDOW);
+	size_t new_size = m_Slots.empty() ? MIN_WINDOW : m_Slots.size();
+	while (new_size < span)
+		new_size *= 2;
+	std::vector<T *> slots(new_size, nullptr);
+	for (size_t i = 0; i < m_Slots.size(); ++i) {
+		size_t key = m_Base + i;
+		slots[key & (new_size - 1)] =
+			m_Slots[key & (m_Slots.size() - 1)];
+	}
+	m_Slots = std::move(slots);
+}
+
+template <class T, size_t MAX_WINDOW>
+void
+SyncTable<T, MAX_WINDOW>::advance()
+{
+	if (m_Count == 0)
+		return;
+	while (m_Slots[m_Base & (m_Slots.size() - 1)] == nullptr)
+		++m_Base;
+}
+
+template <class T, size_t MAX_WINDOW>
+template <class... ARGS>
+T *
+SyncTable<T, MAX_WINDOW>::emplace(size_t key, ARGS &&...args)
+{
+	/*
+	 * Straggler may have a key inside of the window (e.g. once the
+	 * window is moved back), so it is checked first.
+	 */
+	if (!m_Stragglers.empty() && m_Stragglers.count(key) != 0)
+		return nullptr;
+	/* Empty window can be moved to any key. */
+	if (m_Count == 0)
+		m_Base = key;
+	if (key < m_Base || key - m_Base >= MAX_WINDOW) {
+		T *value = create(std::forward<ARGS>(args)...);
+		m_Stragglers.emplace(key, value);
+		return value;
+	}
+	if (key - m_Base >= m_Slots.size())
+		grow(key - m_Base + 1);
+	T *&s = m_Slots[key & (m_Slots.size() - 1)];
+	if (s != nullptr)
+		return nullptr;
+	s = create(std::forward<ARGS>(args)...);
+	++m_Count;
+	return s;
+}
+
+template <class T, size_t MAX_WINDOW>
+void
+SyncTable<T, MAX_WINDOW>::insert(size_t key, T &&value)
+{
+	emplace(key, std::move(value));
+}
+
+template <class T, size_t MAX_WINDOW>
+T *
+SyncTable<T, MAX_WINDOW>::find(size_t key)
+{
+	T **s = slot(key);
+	if (s != nullptr && *s != nullptr)
+		return *s;
+	if (m_Stragglers.empty())
+		return nullptr;
+	auto itr = m_Stragglers.find(key);
+	return itr == m_Stragglers.end() ? nullptr : itr->second;
+}
+
+template <class T, size_t MAX_WINDOW>
+T *
+SyncTable<T, MAX_WINDOW>::unlink(size_t key)
+{
+	T **s = slot(key);
+	if (s != nullptr && *s != nullptr) {
+		T *value = *s;
+		*s = nullptr;
+		--m_Count;
+		advance();
+		return value;
+	}
+	if (m_Stragglers.empty())
+		return nullptr;
+	auto itr = m_Stragglers.find(key);
+	if (itr == m_Stragglers.end())
+		return nullptr;
+	T *value = itr->second;
+	m_Stragglers.erase(itr);
+	return value;
+}
+
+template <class T, size_t MAX_WINDOW>
+std::optional<T>
+SyncTable<T, MAX_WINDOW>::take(size_t key)
+{
+	T *value = unlink(key);
+	if (value == nullptr)
+		return std::nullopt;
+	std::optional<T> res = std::move(*value);
+	destroy(value);
+	return res;
+}
+
+template <class T, size_t MAX_WINDOW>
+bool
+SyncTable<T, MAX_WINDOW>::erase(size_t key)
+{
+	T *value = unlink(key);
+	if (value == nullptr)
+		return false;
+	destroy(value);
+	return true;
+}
+
+template <class T, size_t MAX_WINDOW>
+template <class F>
+void
+SyncTable<T, MAX_WINDOW>::forEach(F &&f)
+{
+	for (size_t i = 0; m_Count != 0 && i < m_Slots.size(); ++i) {
+		size_t key = m_Base + i;
+		T *value = m_Slots[key & (m_Slots.size() - 1)];
+		if (value != nullptr)
+			f(key, *value);
+	}
+	for (auto &straggler : m_Stragglers)
+		f(straggler.first, *straggler.second);
+}
+
+} // namespace tnt {
@@ -0,0 +1,243 @@
+#pragma once
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "List.hpp"
+
+namespace tnt {
+
+/**
+ * Timer of TimerWheel: an intrusive list link plus expiration tick.
+ * Element of the wheel must inherit it:
+ *
+ * struct Object : tnt::WheelTimer<Object> {...};
+ * tnt::TimerWheel<Object> wheel;
+ * wheel.add(object, tick);
+ *
+ * Timer is cancelled by remove() or simply by destruction.
+ */
+template <class Elem>
+struct WheelTimer : SingleLink<Elem> {
+	/** Tick the timer expires at. Valid while the timer is linked. */
+	uint64_t expire_tick = 0;
+};
+
+/**
+ * Hierarchical timing wheel: LEVELS wheels of SLOTS lists each, a slot of
+ * level L spans SLOTS^L ticks. A timer is linked into the slot of the lowest
+ * level which covers its expiration tick and is moved (cascaded) down to
+ * lower levels as the time goes, so both insertion and expiration of a timer
+ * cost O(1) regardless of the count of timers. Timers which are too far for
+ * the whole wheel are put into the top level and re-added on each of its
+ * rotations.
+ * Wheel has no notion of time units: user maps time to ticks itself.
+ */
+template <class Elem, size_t LEVELS = 4>
+class TimerWheel {
+	static_assert(std::is_base_of_v<WheelTimer<Elem>, Elem>, "Must be!");
+	static_assert(LEVELS > 1 && LEVELS <= 10, "Wrong count of levels");
+public:
+	static constexpr size_t SLOT_BITS = 6;
+	static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+	static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+
+	/** Create an empty wheel which current tick is @a now. */
+	explicit TimerWheel(uint64_t now = 0) noexcept;
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+
+	/**
+	 * Link (or relink) @a timer to expire at @a tick. Timer of a
+	 * passed tick expires on the next advance().
+	 */
+	void add(Elem &timer, uint64_t tick) noexcept;
+	/**
+	 * Move current tick to @a now and expire all timers up to it
+	 * inclusive: each of them is unlinked and passed to @a on_expire,
+	 * which is allowed to destroy it or to add any timers.
+	 * Return count of expired timers.
+	 */
+	template <class F>
+	size_t advance(uint64_t now, F &&on_expire);
+	/**
+	 * The earliest tick to advance to in order not to miss an expiration:
+	 * either the tick of the nearest timer of the lowest level or the tick
+	 * of the next cascade. UINT64_MAX if there are no timers.
+	 */
+	uint64_t nextTick() const noexcept;
+	/** The first tick which is not processed yet. */
+	uint64_t now() const noexcept { return m_Now; }
+	bool isEmpty() noexcept;
+private:
+	static constexpr size_t shift(size_t level) { return SLOT_BITS * level; }
+	static constexpr uint64_t bit(size_t slot) { return uint64_t{1} << slot; }
+	/** Re-add timers of the current slot of @a level (and above). */
+	void cascade(size_t level) noexcept;
+
+	List<Elem> m_Slots[LEVELS][SLOTS];
+	/**
+	 * Bitmap of non-empty slots for each level. Timers are unlinked
+	 * behind the wheel's back, so a bit may be stale (set for an empty
+	 * slot): that is only a hint to skip empty slots.
+	 */
+	uint64_t m_Occupied[LEVELS];
+	uint64_t m_Now;
+};
+
+template <class Elem, size_t LEVELS>
+TimerWheel<Elem, LEVELS>::TimerWheel(uint64_t now) noexcept : m_Now(now)
+{
+	for (size_t i = 0; i < LEVELS; ++i)
+		m_Occupied[i] = 0;
+}
+
+template <class Elem, size_t LEVELS>
+void
+TimerWheel<Elem, LEVELS>::add(Elem &timer, uint64_t tick) noexcept
+{
+	if (tick < m_Now)
+		tick = m_Now;
+	timer.expire_tick = tick;
+	/*
+	 * The lowest level which slot index is the only difference between
+	 * the tick and current time. It never equals to the index of current
+	 * slot of the level, since then a lower level would be chosen.
+	 */
+	uint64_t diff = tick ^ m_Now;
+	size_t level = 0;
+	while (level + 1 < LEVELS && (diff >> shift(level + 1)) != 0)
+		++level;
+	size_t slot = (tick >> shift(level)) & SLOT_MASK;
+	m_Slots[level][slot].insert(timer, true);
+	m_Occupied[level] |= bit(slot);
+}
+
+template <class Elem, size_t LEVELS>
+void
+TimerWheel<Elem, LEVELS>::cascade(size_t level) noexcept
+{
+	size_t slot = (m_Now >> shift(level)) & SLOT_MASK;
+	/* Upper level moves first: its timers may fall to this slot. */
+	if (slot == 0 && level + 1 < LEVELS)
+		cascade(level + 1);
+	if ((m_Occupied[level] & bit(slot)) == 0)
+		return;
+	m_Occupied[level] &= ~bit(slot);
+	/* Timers of the top level may return to the same slot. */
+	List<Elem> list(std::move(m_Slots[level][slot]));
+	while (! list.isEmpty()) {
+		Elem &timer = list.first();
+		add(timer, timer.expire_tick);
+	}
+}
+
+template <class Elem, size_t LEVELS>
+template <class F>
+size_t
+TimerWheel<Elem, LEVELS>::advance(uint64_t now, F &&on_expire)
+{
+	size_t count = 0;
+	while (m_Now <= now) {
+		size_t slot = m_Now & SLOT_MASK;
+		if (slot == 0)
+			cascade(1);
+		if ((m_Occupied[0] & bit(slot)) != 0) {
+			m_Occupied[0] &= ~bit(slot);
+			List<Elem> &list = m_Slots[0][slot];
+			while (! list.isEmpty()) {
+				Elem &timer = list.first();
+				timer.remove();
+				++count;
+				on_expire(timer);
+			}
+		}
+		m_Now++;
+		/* Skip empty slots up to the next cascade. */
+		slot = m_Now & SLOT_MASK;
+		if (slot != 0 && (m_Occupied[0] >> slot) == 0) {
+			uint64_t next = (m_Now | SLOT_MASK) + 1;
+			if (next > now) {
+				m_Now = now + 1;
+				break;
+			}
+			m_Now = next;
+		}
+		/* Nothing to cascade: jump right to the end. */
+		if ((m_Now & SLOT_MASK) == 0 && m_Now <= now && isEmpty()) {
+			m_Now = now + 1;
+			break;
+		}
+	}
+	return count;
+}
+
+template <class Elem, size_t LEVELS>
+uint64_t
+TimerWheel<Elem, LEVELS>::nextTick() const noexcept
+{
+	bool cascading = false;
+	for (size_t i = 1; i < LEVELS; ++i)
+		cascading = cascading || m_Occupied[i] != 0;
+	/* Cascade of the current tick may bring any of the nearest timers. */
+	if (cascading && (m_Now & SLOT_MASK) == 0)
+		return m_Now;
+	uint64_t ahead = m_Occupied[0] >> (m_Now & SLOT_MASK);
+	if (ahead != 0)
+		return m_Now + __builtin_ctzll(ahead);
+	if (cascading)
+		return (m_Now | SLOT_MASK) + 1;
+	return UINT64_MAX;
+}
+
+template <class Elem, size_t LEVELS>
+bool
+TimerWheel<Elem, LEVELS>::isEmpty() noexcept
+{
+	/* Drop stale bits on the way, so that it is cheap next time. */
+	for (size_t i = 0; i < LEVELS; ++i) {
+		uint64_t occupied = m_Occupied[i];
+		while (occupied != 0) {
+			size_t slot = __builtin_ctzll(occupied);
+			occupied &= occupied - 1;
+			if (! m_Slots[i][slot].isEmpty())
+				return false;
+			m_Occupied[i] &= ~bit(slot);
+		}
+	}
+	return true;
+}
+
+} // namespace tnt
@@ -487,12 +487,12 @@ Enc<BUFFER>::add_internal(CStr<C...> prefix, const T& t, const MORE&... more)
 	} else if constexpr (is_const_v<T>) {
 		static_assert(always_false_v<T>, "Unknown const!");
 	} else if constexpr (is_constr_v<T> && TYPE == compact::MP_BIN) {
-		constexpr auto add = conv_const_bin<T::size>().join(t);
+		constexpr auto add = conv_const_bin<T::size>().join(T{});
 		add_internal<compact::MP_END, false, void>(prefix.join(add), more...);
 	} else if constexpr (is_constr_v<T>) {
 		static_assert(TYPE == compact::MP_END || TYPE == compact::MP_STR,
 			"What else can be packed as string?");
-		constexpr auto add = conv_const_str<T::size>().join(t);
+		constexpr auto add = conv_const_str<T::size>().join(T{});
 		add_internal<compact::MP_END, false, void>(prefix.join(add), more...);
 	} else if constexpr (is_raw_v<T>) {
 		m_Buf.addBack(prefix);
@@ -628,10 +628,19 @@ Enc<BUFFER>::add_internal(CStr<C...> prefix, const T& t, const MORE&... more)
 			for (const auto& x : t)
 				add_internal<compact::MP_END, false, void>(CStr<>(), x);
 		} else if constexpr (is_tuple_v<T>) {
-			add_arr(prefix, std::tuple_size_v<T>);
-			std::apply([this](const auto& ...x) {
-				(..., this->template add_internal<compact::MP_END, false, void>(CStr<>(), x));
+			/*
+			 * Header of tuple is known at compile time. Elements
+			 * are encoded in line with the rest, so the header and
+			 * adjacent constant elements are joined into a single
+			 * compile-time string.
+			 */
+			constexpr auto add =
+				conv_const_arr<std::tuple_size_v<T>>();
+			std::apply([&](const auto& ...x) {
+				this->template add_internal<compact::MP_END, false, void>(
+					prefix.join(add), x..., more...);
 			}, t);
+			return;
 		} else {
 			static_assert(always_false_v<T>,
 				      "Wrong thing was passed as array");
@@ -652,10 +661,14 @@ Enc<BUFFER>::add_internal(CStr<C...> prefix, const T& t, const MORE&... more)
 		} else if constexpr (is_tuple_v<T>) {
 			static_assert(std::tuple_size_v<T> % 2 == 0,
 				      "Map expects even number of elements");
-			add_map(prefix, std::tuple_size_v<T> / 2);
-			std::apply([this](const auto& ...x) {
-				(..., this->template add_internal<compact::MP_END, false, void>(CStr<>(), x));
+			/* Encoded in line, see tuple as array above. */
+			constexpr auto add =
+				conv_const_map<std::tuple_size_v<T> / 2>();
+			std::apply([&](const auto& ...x) {
+				this->template add_internal<compact::MP_END, false, void>(
+					prefix.join(add), x..., more...);
 			}, t);
+			return;
 		} else {
 			static_assert(always_false_v<T>,
 				      "Wrong thing was passed as map");
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "Utils/Helpers.hpp"
+#include "Utils/TupleReader.hpp"
+#include "Utils/System.hpp"
+
+#include "../src/Client/LibevNetProvider.hpp"
+#include "../src/Client/Connector.hpp"
+#include "../src/Client/Coroutine.hpp"
+
+const char *localhost = "127.0.0.1";
+int port = 3301;
+int WAIT_TIMEOUT = 1000; //milliseconds
+
+template <class BUFFER, class NetProvider>
+ClientTask
+replace_and_select(Connection<BUFFER, NetProvider> &conn, int key,
+		   std::vector<UserTuple> &result)
+{
+	std::tuple data = std::make_tuple(key, "111", 1.01);
+	Response<BUFFER> response =
+		co_await awaitResponse(conn, conn.space[512].replace(data));
+	fail_unless(response.body.error_stack == std::nullopt);
+	response = co_await awaitResponse(conn,
+		conn.space[512].select(std::make_tuple(key)));
+	fail_unless(response.body.data != std::nullopt);
+	result = decodeUserTuple(conn.getInBuf(), *response.body.data);
+}
+
+template <class BUFFER, class NetProvider>
+ClientTask
+ping_forever(Connection<BUFFER, NetProvider> &conn, size_t &count)
+{
+	for (;;) {
+		Response<BUFFER> response =
+			co_await awaitResponse(conn, conn.ping());
+		fail_unless(response.header.code == 0);
+		count++;
+	}
+}
+
+template <class BUFFER, class NetProvider>
+void
+coroutine_requests(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	using Conn_t = Connection<BUFFER, NetProvider>;
+	Conn_t conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+
+	TEST_CASE("Sequence of awaits");
+	std::vector<UserTuple> result;
+	ClientTask task = replace_and_select(conn, 1, result);
+	fail_unless(!task.done());
+	rc = runUntil(client, [&]() { return task.done(); }, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(result.size() == 1);
+	fail_unless(result[0].field1 == 1);
+
+	TEST_CASE("Many interleaved coroutines");
+	const int TASK_COUNT = 10;
+	std::vector<std::vector<UserTuple>> results(TASK_COUNT);
+	std::vector<ClientTask> tasks;
+	for (int i = 0; i < TASK_COUNT; ++i)
+		tasks.push_back(replace_and_select(conn, i, results[i]));
+	auto all_done = [&]() {
+		for (const ClientTask &t : tasks)
+			if (!t.done())
+				return false;
+		return true;
+	};
+	rc = runUntil(client, all_done, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	for (int i = 0; i < TASK_COUNT; ++i) {
+		fail_unless(results[i].size() == 1);
+		fail_unless(results[i][0].field1 == (uint64_t) i);
+	}
+
+	TEST_CASE("Await of already decoded response does not suspend");
+	rid_t f = conn.ping();
+	client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(conn.futureIsReady(f));
+	auto await_ready = [](Conn_t &conn, rid_t f) -> ClientTask {
+		Response<BUFFER> response = co_await awaitResponse(conn, f);
+		fail_unless(response.header.sync == (int) f);
+	};
+	ClientTask ready_task = await_ready(conn, f);
+	fail_unless(ready_task.done());
+	fail_unless(!conn.futureIsReady(f));
+
+	TEST_CASE("Destroy suspended coroutine");
+	size_t count = 0;
+	{
+		ClientTask endless = ping_forever(conn, count);
+		rc = runUntil(client, [&]() { return count >= 100; },
+			      WAIT_TIMEOUT);
+		fail_unless(rc == 0);
+	}
+	/* Response of the abandoned ping is stored as usual. */
+	f = conn.ping();
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(count == 100);
+
+	TEST_CASE("Timeout");
+	ClientTask never = []() -> ClientTask {
+		co_await std::suspend_always{};
+	}();
+	rc = runUntil(client, [&]() { return never.done(); }, 100);
+	fail_unless(rc != 0);
+
+	client.close(conn);
+}
+
+int main()
+{
+	if (cleanDir() != 0)
+		return -1;
+	if (launchTarantool() != 0)
+		return -1;
+	sleep(1);
+	Connector<Buf_t> client;
+	coroutine_requests(client);
+	using NetLibEv_t = LibevNetProvider<Buf_t, NetworkEngine>;
+	Connector<Buf_t, NetLibEv_t> ev_client;
+	coroutine_requests(ev_client);
+	return 0;
+}
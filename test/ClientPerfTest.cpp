@@ -34,12 +34,23 @@
 #include "Utils/PerfTimer.hpp"
 
 #include "../src/Client/Connector.hpp"
+#include "../src/Client/ConnectionPool.hpp"
+#include "../src/Client/ShardedClient.hpp"
 #include "../src/Client/LibevNetProvider.hpp"
+#ifdef TNTCXX_ENABLE_URING
+#include "../src/Client/UringNetProvider.hpp"
+#endif
+
+#include <memory>
+#include <thread>
+#include <vector>
 
 static const char *localhost = "127.0.0.1";
 static constexpr size_t port = 3301;
 static constexpr size_t space_id = 512;
 static size_t suite_numb = 0;
+/** Additional instances for sharded test; main one is the first shard. */
+static constexpr int shard_ports[] = {3311, 3312, 3313};
 
 static constexpr int WAIT_TIMEOUT = 10000; //milliseconds
 
@@ -60,6 +71,8 @@ struct RequestResult {
 struct BenchResults {
 	RequestResult ping;
 	RequestResult replace;
+	/** Fire-and-forget replaces consumed by response handler. */
+	RequestResult replace_handler;
 	RequestResult select;
 };
 
@@ -74,6 +87,9 @@ void printResults(BenchResults &r)
 	std::cout << "+  REPLACE " << std::endl;
 	std::cout << "+          MRPS        " << r.replace.rps / 1000000 << std::endl;
 	std::cout << "+          SERVER RPS  " << r.replace.server_rps    << std::endl;
+	std::cout << "+  REPLACE (HANDLER) " << std::endl;
+	std::cout << "+          MRPS        " << r.replace_handler.rps / 1000000 << std::endl;
+	std::cout << "+          SERVER RPS  " << r.replace_handler.server_rps    << std::endl;
 	std::cout << "+  SELECT " << std::endl;
 	std::cout << "+          MRPS        " << r.select.rps / 1000000 << std::endl;
 	std::cout << "+          SERVER RPS  " << r.select.server_rps    << std::endl;
@@ -97,18 +113,10 @@ executeRequest(Connection<BUFFER, NetProvider> &conn, int request_type, int key)
 }
 
 template<class BUFFER, class NetProvider>
-RequestResult
-testBatchRequests(int request_type)
+void
+executeBatches(Connector<BUFFER, NetProvider> &client,
+	       Connection<BUFFER, NetProvider> &conn, int request_type)
 {
-	Connector<BUFFER, NetProvider> client;
-	Connection<BUFFER, NetProvider> conn(client);
-	int rc = client.connect(conn, localhost, port);
-	if (rc != 0) {
-		std::cerr << "Failed to connect to localhost:" << port << std::endl;
-		abort();
-	}
-	PerfTimer timer;
-	timer.start();
 	for (size_t k = 0; k < NUM_TEST; k++) {
 		rid_t ids[NUM_REQ];
 		for (size_t i = 0; i < NUM_REQ; i++)
@@ -125,6 +133,54 @@ testBatchRequests(int request_type)
 			}
 		}
 	}
+}
+
+/** Replaces whose responses are consumed by handler, not stored. */
+template<class BUFFER, class NetProvider>
+void
+executeHandledBatches(Connector<BUFFER, NetProvider> &client,
+		      Connection<BUFFER, NetProvider> &conn)
+{
+	size_t handled = 0;
+	auto handler = [&handled](Response<BUFFER> &response) {
+		if (response.header.code != 0)
+			abort();
+		handled++;
+	};
+	for (size_t k = 0; k < NUM_TEST; k++) {
+		rid_t ids[NUM_REQ];
+		for (size_t i = 0; i < NUM_REQ; i++) {
+			ids[i] = conn.space[space_id].replace(
+				std::make_tuple(i, "str", 1.01), handler);
+		}
+		client.waitAll(conn, ids, NUM_REQ, WAIT_TIMEOUT);
+	}
+	if (handled != NUM_REQ * NUM_TEST) {
+		std::cerr << "Test failed: not all responses are handled!" << std::endl;
+		abort();
+	}
+}
+
+template<class BUFFER, class NetProvider>
+RequestResult
+testBatchRequests(int request_type, void (*setup)(NetProvider &),
+		  bool with_handler = false)
+{
+	Connector<BUFFER, NetProvider> client;
+	if (setup != nullptr)
+		setup(client.getNetProvider());
+	Connection<BUFFER, NetProvider> conn(client);
+	int rc = client.connect(conn, localhost, port);
+	if (rc != 0) {
+		std::cerr << "Failed to connect to localhost:" << port << std::endl;
+		abort();
+	}
+	PerfTimer timer;
+	timer.start();
+	if (with_handler)
+		executeHandledBatches(client, conn);
+	else
+		executeBatches(client, conn, request_type);
 	timer.stop();
 	RequestResult r;
 	r.rps = NUM_REQ * NUM_TEST / timer.result();
@@ -133,17 +189,231 @@ testBatchRequests(int request_type)
 	return r;
 }
 
+/**
+ * @a setup is applied to network provider before connecting, so that
+ * the same provider can be benchmarked in different modes.
+ */
 template<class BUFFER, class NetProvider>
 void
-testRequestTypes()
+testRequestTypes(void (*setup)(NetProvider &) = nullptr)
 {
 	BenchResults r;
-	r.ping = testBatchRequests<BUFFER, NetProvider>(Iproto::PING);
-	r.replace = testBatchRequests<BUFFER, NetProvider>(Iproto::REPLACE);
-	r.select = testBatchRequests<BUFFER, NetProvider>(Iproto::SELECT);
+	r.ping = testBatchRequests<BUFFER, NetProvider>(Iproto::PING, setup);
+	r.replace = testBatchRequests<BUFFER, NetProvider>(Iproto::REPLACE, setup);
+	r.replace_handler = testBatchRequests<BUFFER, NetProvider>(Iproto::REPLACE,
+								 setup, true);
+	r.select = testBatchRequests<BUFFER, NetProvider>(Iproto::SELECT, setup);
 	printResults(r);
 }
 
+/**
+ * Encode requests round-robin over many connections, so that all of them
+ * are queued to be sent. Enqueueing a connection is O(1), so encoding rate
+ * must not depend on count of connections.
+ */
+template<class BUFFER, class NetProvider>
+void
+testManyConnectionsEncode(const char *provider_name)
+{
+	constexpr size_t TOTAL_REQ = 1000000;
+	std::cout << "===================================================" << std::endl;
+	std::cout << "        STARTING TEST ENCODE " << provider_name << std::endl;
+	std::cout << "===================================================" << std::endl;
+	for (size_t conn_count : {1000, 2000, 5000, 10000}) {
+		Connector<BUFFER, NetProvider> client;
+		std::vector<std::unique_ptr<Connection<BUFFER, NetProvider>>> conns;
+		for (size_t i = 0; i < conn_count; i++)
+			conns.emplace_back(new Connection<BUFFER, NetProvider>(client));
+		PerfTimer timer;
+		timer.start();
+		for (size_t k = 0; k < TOTAL_REQ / conn_count; k++) {
+			for (auto &conn : conns)
+				conn->ping();
+		}
+		timer.stop();
+		std::cout << "+  CONNECTIONS " << conn_count << std::endl;
+		std::cout << "+          ENCODE MRPS  " << TOTAL_REQ / timer.result() / 1000000
+			  << std::endl;
+	}
+}
+
+/**
+ * Thread-per-Connector: each thread owns its Connector and Connection.
+ * Returns total requests per second of all threads.
+ */
+template<class BUFFER, class NetProvider>
+double
+testThreadRequests(size_t thread_count, int request_type)
+{
+	std::vector<std::thread> threads;
+	PerfTimer timer;
+	timer.start();
+	for (size_t t = 0; t < thread_count; t++) {
+		threads.emplace_back([request_type] {
+			Connector<BUFFER, NetProvider> client;
+			Connection<BUFFER, NetProvider> conn(client);
+			if (client.connect(conn, localhost, port) != 0) {
+				std::cerr << "Failed to connect to localhost:" << port << std::endl;
+				abort();
+			}
+			executeBatches(client, conn, request_type);
+			client.close(conn);
+		});
+	}
+	for (auto &thread : threads)
+		thread.join();
+	timer.stop();
+	return NUM_REQ * NUM_TEST * thread_count / timer.result();
+}
+
+template<class BUFFER, class NetProvider>
+void
+testThreads()
+{
+	size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::cout << "===================================================" << std::endl;
+	std::cout << "        STARTING MULTITHREADED TEST" << std::endl;
+	std::cout << "        BUFFER SIZE=" << BUFFER::blockSize() << std::endl;
+	std::cout << "===================================================" << std::endl;
+	for (size_t thread_count = 1; ; thread_count *= 2) {
+		thread_count = std::min(thread_count, max_threads);
+		double rps = testThreadRequests<BUFFER, NetProvider>(thread_count,
+								     Iproto::PING);
+		std::cout << "+  THREADS " << thread_count << std::endl;
+		std::cout << "+          PING MRPS        " << rps / 1000000 << std::endl;
+		std::cout << "+          PER THREAD MRPS  " << rps / thread_count / 1000000 << std::endl;
+		if (thread_count == max_threads)
+			break;
+	}
+}
+
+/**
+ * Cold start of many connections: one by one with blocking connect versus
+ * all of them at once with asynchronous one.
+ */
+template<class BUFFER, class NetProvider>
+void
+testConnect()
+{
+	std::cout << "===================================================" << std::endl;
+	std::cout << "        STARTING CONNECT TEST" << std::endl;
+	std::cout << "===================================================" << std::endl;
+	constexpr size_t CONN_COUNT = 100;
+	for (bool is_async : {false, true}) {
+		Connector<BUFFER, NetProvider> client;
+		std::vector<std::unique_ptr<Connection<BUFFER, NetProvider>>> conns;
+		PerfTimer timer;
+		timer.start();
+		for (size_t i = 0; i < CONN_COUNT; ++i) {
+			conns.push_back(std::make_unique<Connection<BUFFER, NetProvider>>(client));
+			int rc = is_async ?
+				client.connectAsync(*conns.back(), localhost, port) :
+				client.connect(*conns.back(), localhost, port);
+			if (rc != 0) {
+				std::cerr << "Failed to connect to localhost:" << port << std::endl;
+				abort();
+			}
+		}
+		for (auto &conn : conns) {
+			if (client.waitConnect(*conn) != 0) {
+				std::cerr << "Test failed: connect failed!" << std::endl;
+				abort();
+			}
+		}
+		timer.stop();
+		std::cout << "+  " << (is_async ? "ASYNC" : "BLOCKING") << std::endl;
+		std::cout << "+          CONNECTIONS PER SEC  " <<
+			CONN_COUNT / timer.result() << std::endl;
+		for (auto &conn : conns)
+			client.close(*conn);
+	}
+}
+
+/**
+ * Replaces are routed over pool of connections to the same instance,
+ * so that they are processed by several iproto threads of the server.
+ */
+template<class BUFFER, class NetProvider>
+void
+testPool()
+{
+	std::cout << "===================================================" << std::endl;
+	std::cout << "        STARTING CONNECTION POOL TEST" << std::endl;
+	std::cout << "===================================================" << std::endl;
+	for (size_t conn_count : {1, 2, 4, 8}) {
+		Connector<BUFFER, NetProvider> client;
+		ConnectionPool<BUFFER, NetProvider> pool(client);
+		if (pool.connect(localhost, port, conn_count) != 0) {
+			std::cerr << "Failed to connect to localhost:" << port << std::endl;
+			abort();
+		}
+		auto handler = [](Response<BUFFER> &response) {
+			if (response.header.code != 0)
+				abort();
+		};
+		PerfTimer timer;
+		timer.start();
+		for (size_t k = 0; k < NUM_TEST; k++) {
+			for (size_t i = 0; i < NUM_REQ; i++) {
+				pool.get()->space[space_id].replace(
+					std::make_tuple(i, "str", 1.01), handler);
+			}
+			if (pool.waitAll(WAIT_TIMEOUT) != 0) {
+				std::cerr << "Test failed: pool wait failed!" << std::endl;
+				abort();
+			}
+		}
+		timer.stop();
+		std::cout << "+  CONNECTIONS " << conn_count << std::endl;
+		std::cout << "+          REPLACE MRPS  " <<
+			NUM_REQ * NUM_TEST / timer.result() / 1000000 << std::endl;
+	}
+}
+
+/**
+ * Replaces are routed by key over 1..4 shards (separate instances), so
+ * throughput is expected to scale with count of shards.
+ */
+template<class BUFFER, class NetProvider>
+void
+testShards()
+{
+	std::cout << "===================================================" << std::endl;
+	std::cout << "        STARTING SHARDED TEST" << std::endl;
+	std::cout << "===================================================" << std::endl;
+	for (size_t shard_count = 1; shard_count <= 4; shard_count++) {
+		Connector<BUFFER, NetProvider> client;
+		ShardedClient<BUFFER, NetProvider> sharded(client);
+		for (size_t i = 0; i < shard_count; i++) {
+			int shard_port = i == 0 ? port : shard_ports[i - 1];
+			if (sharded.addShard(localhost, shard_port) < 0) {
+				std::cerr << "Failed to connect to localhost:" << shard_port << std::endl;
+				abort();
+			}
+		}
+		auto handler = [](Response<BUFFER> &response) {
+			if (response.header.code != 0)
+				abort();
+		};
+		PerfTimer timer;
+		timer.start();
+		for (size_t k = 0; k < NUM_TEST; k++) {
+			for (size_t i = 0; i < NUM_REQ; i++) {
+				sharded.route(i).space[space_id].replace(
+					std::make_tuple(i, "str", 1.01), handler);
+			}
+			if (sharded.waitAll(WAIT_TIMEOUT) != 0) {
+				std::cerr << "Test failed: sharded wait failed!" << std::endl;
+				abort();
+			}
+		}
+		timer.stop();
+		std::cout << "+  SHARDS " << shard_count << std::endl;
+		std::cout << "+          REPLACE MRPS  " <<
+			NUM_REQ * NUM_TEST / timer.result() / 1000000 << std::endl;
+	}
+}
+
 template<class BUFFER>
 void
 testEngines()
@@ -159,9 +429,22 @@ testEngines()
 	std::cout << "===================================================" << std::endl;
 	testRequestTypes<BUFFER, DefaultNet_t >();
 	std::cout << "===================================================" << std::endl;
+	std::cout << "        STARTING TEST EPOLL EDGE-TRIGGERED" << std::endl;
+	std::cout << "===================================================" << std::endl;
+	testRequestTypes<BUFFER, DefaultNet_t >([](DefaultNet_t &net) {
+		net.setEdgeTriggered(true);
+	});
+	std::cout << "===================================================" << std::endl;
 	std::cout << "        STARTING TEST LibEV" << std::endl;
 	std::cout << "===================================================" << std::endl;
 	testRequestTypes<BUFFER, LibEvNet_t >();
+#ifdef TNTCXX_ENABLE_URING
+	using UringNet_t = UringNetProvider<BUFFER, NetworkEngine >;
+	std::cout << "===================================================" << std::endl;
+	std::cout << "        STARTING TEST io_uring" << std::endl;
+	std::cout << "===================================================" << std::endl;
+	testRequestTypes<BUFFER, UringNet_t >();
+#endif
 }
 
 template<class BUFFER, class NetProvider>
@@ -214,10 +497,28 @@ int main()
 		std::cerr << "Failed to launch server" << std::endl;
 		return -1;
 	}
+	for (int shard_port : shard_ports) {
+		if (launchTarantool(shard_port) != 0) {
+			std::cerr << "Failed to launch server" << std::endl;
+			return -1;
+		}
+	}
 	sleep(1);
 
 	testBuffer(std::index_sequence<SMALL_BUFFER_SIZE, AVERAGE_BUFFER_SIZE,
 				       BIG_BUFFER_SIZE, GIANT_BUFFER_SIZE>{});
 
+	using Buf_t = tnt::Buffer<BIG_BUFFER_SIZE>;
+	testThreads<Buf_t, DefaultNetProvider<Buf_t, NetworkEngine>>();
+	testConnect<Buf_t, DefaultNetProvider<Buf_t, NetworkEngine>>();
+	testPool<Buf_t, DefaultNetProvider<Buf_t, NetworkEngine>>();
+	testShards<Buf_t, DefaultNetProvider<Buf_t, NetworkEngine>>();
+
+	using SmallBuf_t = tnt::Buffer<SMALL_BUFFER_SIZE>;
+	testManyConnectionsEncode<SmallBuf_t,
+		DefaultNetProvider<SmallBuf_t, NetworkEngine>>("EPOLL");
+	testManyConnectionsEncode<SmallBuf_t,
+		LibevNetProvider<SmallBuf_t, NetworkEngine>>("LibEV");
+
 	return 0;
 }
@@ -33,11 +33,19 @@
 #include "Utils/System.hpp"
 
 #include "../src/Client/LibevNetProvider.hpp"
+#ifdef TNTCXX_ENABLE_URING
+#include "../src/Client/UringNetProvider.hpp"
+#endif
 #include "../src/Client/Connector.hpp"
+#include "../src/Client/ConnectionPool.hpp"
+#include "../src/Client/ShardedClient.hpp"
+#include "../src/Client/ScatterSelect.hpp"
 
 const char *localhost = "127.0.0.1";
 int port = 3301;
 int WAIT_TIMEOUT = 1000; //milliseconds
+/** Additional instances serving as shards along with the main one. */
+int shard_ports[] = {3311, 3312};
 
 using Net_t = DefaultNetProvider<Buf_t, NetworkEngine>;
 
@@ -159,6 +167,371 @@ single_conn_ping(Connector<BUFFER, NetProvider> &client)
 		fail_unless(response->header.code == 0);
 		fail_unless(response->body.error_stack == std::nullopt);
 	}
+	/* Readiness of each future is reported even on timeout. */
+	bool ready[3];
+	features[0] = conn.ping();
+	features[1] = 666;
+	features[2] = conn.ping();
+	rc = client.waitAll(conn, (rid_t *) &features, 3, 100, ready);
+	fail_unless(rc != 0);
+	fail_unless(ready[0] && !ready[1] && ready[2]);
+	fail_unless(conn.futureIsReady(features[2]));
+	rc = client.waitAll(conn, (rid_t *) &features, 1, WAIT_TIMEOUT, ready);
+	fail_unless(rc == 0);
+	fail_unless(ready[0]);
+	client.close(conn);
+}
+
+/** Single connection, requests batching with cork and flush policy. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_flush(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<Buf_t, NetProvider> conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+	TEST_CASE("Corked connection holds requests");
+	conn.cork();
+	rid_t features[8];
+	for (int i = 0; i < 3; ++i)
+		features[i] = conn.ping();
+	fail_unless(conn.getStat().send == 3);
+	fail_unless(conn.getStat().flushes == 0);
+	rc = client.wait(conn, features[0], 100);
+	fail_unless(rc != 0);
+	fail_unless(!conn.futureIsReady(features[0]));
+	TEST_CASE("Explicit flush");
+	conn.flush();
+	fail_unless(conn.getStat().flushes == 1);
+	fail_unless(conn.getStat().flushed_requests == 3);
+	fail_unless(conn.getStat().flush_explicit == 1);
+	client.waitAll(conn, (rid_t *) &features, 3, WAIT_TIMEOUT);
+	for (int i = 0; i < 3; ++i)
+		fail_unless(conn.futureIsReady(features[i]));
+	fail_unless(conn.getStat().read == 3);
+	conn.uncork();
+	fail_unless(conn.getStat().flushes == 1);
+	TEST_CASE("Flush by count of requests");
+	FlushPolicy policy;
+	policy.requests = 4;
+	conn.setFlushPolicy(policy);
+	for (int i = 0; i < 8; ++i)
+		features[i] = conn.ping();
+	fail_unless(conn.getStat().flush_by_requests == 2);
+	client.waitAll(conn, (rid_t *) &features, 8, WAIT_TIMEOUT);
+	for (int i = 0; i < 8; ++i)
+		fail_unless(conn.futureIsReady(features[i]));
+	TEST_CASE("Flush on wait");
+	features[0] = conn.ping();
+	fail_unless(conn.getStat().flushes == 3);
+	client.wait(conn, features[0], WAIT_TIMEOUT);
+	fail_unless(conn.futureIsReady(features[0]));
+	fail_unless(conn.getStat().flush_by_wait == 1);
+	TEST_CASE("Flush by bytes");
+	policy.requests = 0;
+	policy.bytes = 1;
+	conn.setFlushPolicy(policy);
+	features[0] = conn.ping();
+	fail_unless(conn.getStat().flush_by_bytes == 1);
+	client.wait(conn, features[0], WAIT_TIMEOUT);
+	fail_unless(conn.futureIsReady(features[0]));
+	fail_unless(conn.getStat().flushes == 5);
+	fail_unless(conn.getStat().flushed_requests == conn.getStat().send);
+	client.close(conn);
+}
+
+/** Many connections are established in parallel, requests are queued. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+many_conn_connect_async(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	constexpr size_t CONN_COUNT = 8;
+	std::vector<std::unique_ptr<Connection<Buf_t, NetProvider>>> conns;
+	std::vector<rid_t> futures;
+	for (size_t i = 0; i < CONN_COUNT; ++i) {
+		conns.push_back(std::make_unique<Connection<Buf_t, NetProvider>>(client));
+		int rc = client.connectAsync(*conns.back(), localhost, port);
+		fail_unless(rc == 0);
+		/* Sent as soon as the connection is established. */
+		futures.push_back(conns.back()->ping());
+	}
+	for (size_t i = 0; i < CONN_COUNT; ++i) {
+		int rc = client.wait(*conns[i], futures[i], WAIT_TIMEOUT);
+		fail_unless(rc == 0);
+		fail_unless(!conns[i]->status.is_connecting);
+		std::optional<Response<Buf_t>> response =
+			conns[i]->getResponse(futures[i]);
+		fail_unless(response != std::nullopt);
+		fail_unless(response->header.code == 0);
+	}
+	fail_unless(client.waitConnect(*conns[0], WAIT_TIMEOUT) == 0);
+	for (auto &conn : conns)
+		client.close(*conn);
+	TEST_CASE("Connect to closed port fails");
+	Connection<Buf_t, NetProvider> conn(client);
+	if (client.connectAsync(conn, localhost, 1) == 0) {
+		fail_unless(client.waitConnect(conn, WAIT_TIMEOUT) != 0);
+		fail_unless(conn.status.is_failed);
+		fail_unless(!conn.status.is_connecting);
+	}
+}
+
+/** Single connection is restored after the socket is broken. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_reconnect(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<Buf_t, NetProvider> conn(client);
+	ReconnectPolicy policy;
+	policy.enabled = true;
+	policy.initial_delay = std::chrono::milliseconds(10);
+	conn.setReconnectPolicy(policy);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+	rid_t f = conn.ping();
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	conn.getResponse(f);
+	TEST_CASE("Sent request fails, unsent ping is replayed");
+	rid_t features[3];
+	features[0] = conn.ping();
+	client.flush(conn);
+	::shutdown(conn.socket, SHUT_RDWR);
+	features[1] = conn.ping();
+	features[2] = conn.call("remote_uint", std::make_tuple());
+	rc = client.waitAll(conn, (rid_t *) &features, 3, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(!conn.isReconnecting());
+	std::optional<Response<Buf_t>> response = conn.getResponse(features[0]);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == 0 ||
+		    response->header.code == (Iproto::TYPE_ERROR |
+					      (int) Iproto::ER_NO_CONNECTION));
+	response = conn.getResponse(features[1]);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == 0);
+	response = conn.getResponse(features[2]);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == (Iproto::TYPE_ERROR |
+					      (int) Iproto::ER_NO_CONNECTION));
+	fail_unless(response->body.error_stack != std::nullopt);
+	fail_unless(response->body.error_stack->error.errcode ==
+		    Iproto::ER_NO_CONNECTION);
+	TEST_CASE("Marked request is replayed");
+	::shutdown(conn.socket, SHUT_RDWR);
+	f = conn.call("remote_uint", std::make_tuple());
+	conn.setReplayable(f);
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == 0);
+	client.close(conn);
+}
+
+/** Requests which are not answered by their deadlines fail with error. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_deadline(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<Buf_t, NetProvider> conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+	TEST_CASE("Expired future gets error, late response is dropped");
+	const ConnectionStat &stat = conn.getStat();
+	size_t read = stat.read;
+	/* Corked request is not sent, so it can't be answered in time. */
+	conn.cork();
+	rid_t f = conn.ping();
+	conn.setDeadline(f, std::chrono::steady_clock::now() +
+			    std::chrono::milliseconds(10));
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	std::optional<Response<Buf_t>> response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == (Iproto::TYPE_ERROR |
+					      (int) Iproto::ER_TIMEOUT));
+	fail_unless(response->body.error_stack != std::nullopt);
+	fail_unless(response->body.error_stack->error.errcode ==
+		    Iproto::ER_TIMEOUT);
+	fail_unless(conn.getInFlight() == 0);
+	fail_unless(stat.timed_out == 1);
+	fail_unless(stat.read == read);
+	conn.uncork();
+	rid_t next = conn.ping();
+	rc = client.wait(conn, next, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(! conn.futureIsReady(f));
+	fail_unless(conn.getInFlight() == 0);
+	conn.getResponse(next);
+	/* Late response is read, but only the next one has latency. */
+	fail_unless(stat.read == read + 2);
+	fail_unless(conn.getLatency(Iproto::PING)->count() == 1);
+	TEST_CASE("Request timeout");
+	conn.setRequestTimeout(std::chrono::milliseconds(WAIT_TIMEOUT));
+	f = conn.ping();
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == 0);
+	conn.setRequestTimeout(std::chrono::milliseconds(10));
+	conn.cork();
+	bool is_expired = false;
+	f = conn.ping([&](Response<Buf_t> &response) {
+		is_expired = response.header.code ==
+			     (Iproto::TYPE_ERROR | (int) Iproto::ER_TIMEOUT);
+	});
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(is_expired);
+	conn.setRequestTimeout(std::chrono::milliseconds(0));
+	conn.uncork();
+	next = conn.ping();
+	rc = client.wait(conn, next, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(! conn.futureIsReady(f));
+	conn.getResponse(next);
+	client.close(conn);
+}
+
+/** chap-sha1 AUTH is pipelined right behind the greeting. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_auth(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<Buf_t, NetProvider> conn(client);
+	conn.setCredentials("test", "test");
+	TEST_CASE("Requests queued during connect go after AUTH");
+	int rc = client.connectAsync(conn, localhost, port);
+	fail_unless(rc == 0);
+	rid_t f = conn.call("remote_uint", std::make_tuple());
+	rc = client.waitConnect(conn, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	std::optional<Response<Buf_t>> response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == 0);
+	fail_unless(conn.getInFlight() == 0);
+	client.close(conn);
+	TEST_CASE("Blocking connect");
+	rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+	f = conn.ping();
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(! conn.status.is_authenticating);
+	conn.getResponse(f);
+	TEST_CASE("Reconnect authenticates again");
+	ReconnectPolicy policy;
+	policy.enabled = true;
+	policy.initial_delay = std::chrono::milliseconds(10);
+	conn.setReconnectPolicy(policy);
+	::shutdown(conn.socket, SHUT_RDWR);
+	f = conn.ping();
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == 0);
+	fail_unless(! conn.status.is_authenticating);
+	client.close(conn);
+	TEST_CASE("Wrong password");
+	Connection<Buf_t, NetProvider> bad(client);
+	bad.setCredentials("test", "wrong");
+	bad.setReconnectPolicy(policy);
+	rc = client.connectAsync(bad, localhost, port);
+	fail_unless(rc == 0);
+	rc = client.waitConnect(bad, WAIT_TIMEOUT);
+	fail_unless(rc != 0);
+	fail_unless(bad.status.is_failed);
+	fail_unless(! bad.isReconnecting());
+	fail_unless(bad.getError().find("Authentication failed") == 0);
+}
+
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_stats(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<Buf_t, NetProvider> conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+	ConnectionStat before = client.getStat();
+	TEST_CASE("Counters");
+	rid_t ping = conn.ping();
+	rid_t select = conn.space[512].select(std::make_tuple(666));
+	client.wait(conn, select, WAIT_TIMEOUT);
+	client.wait(conn, ping, WAIT_TIMEOUT);
+	fail_unless(conn.futureIsReady(ping));
+	fail_unless(conn.futureIsReady(select));
+	const ConnectionStat &stat = conn.getStat();
+	fail_unless(stat.send == 2);
+	fail_unless(stat.read == 2);
+	fail_unless(stat.bytes_sent > 0);
+	fail_unless(stat.bytes_received > 0);
+	fail_unless(stat.send_calls > 0);
+	fail_unless(stat.recv_calls > 0);
+	fail_unless(stat.partial_writes <= stat.send_calls);
+	TEST_CASE("Latency histograms");
+	const LatencyHistogram *ping_latency = conn.getLatency(Iproto::PING);
+	const LatencyHistogram *select_latency = conn.getLatency(Iproto::SELECT);
+	fail_unless(ping_latency != nullptr && ping_latency->count() == 1);
+	fail_unless(select_latency != nullptr && select_latency->count() == 1);
+	fail_unless(select_latency->max() > 0);
+	fail_unless(conn.getLatency(Iproto::INSERT) == nullptr);
+	TEST_CASE("Connector aggregates statistics");
+	const ConnectionStat &total = client.getStat();
+	fail_unless(total.send - before.send == stat.send);
+	fail_unless(total.read - before.read == stat.read);
+	fail_unless(total.bytes_sent - before.bytes_sent == stat.bytes_sent);
+	fail_unless(total.bytes_received - before.bytes_received ==
+		    stat.bytes_received);
+	fail_unless(client.getLatency(Iproto::SELECT) != nullptr);
+	fail_unless(client.getLatency(Iproto::SELECT)->count() >= 1);
+	TEST_CASE("Failed requests are not counted as responses");
+	size_t read = stat.read;
+	::shutdown(conn.socket, SHUT_RDWR);
+	rid_t lost = conn.ping();
+	client.wait(conn, lost, WAIT_TIMEOUT);
+	fail_unless(conn.futureIsReady(lost));
+	fail_unless(stat.read == read);
+	fail_unless(stat.failed == 1);
+	fail_unless(total.failed - before.failed == 1);
+	fail_unless(ping_latency->count() == 1);
+	conn.getResponse(lost);
+	conn.reset();
+	client.close(conn);
+}
+
+/** Deep pipeline which spans many more buffer blocks than initial iovec count. */
+template <class BUFFER, class NetProvider>
+void
+single_conn_pipeline(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<BUFFER, NetProvider> conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+	constexpr size_t PIPELINE_SIZE = 1000;
+	std::vector<rid_t> futures(PIPELINE_SIZE);
+	conn.cork();
+	for (size_t i = 0; i < PIPELINE_SIZE; ++i)
+		futures[i] = conn.ping();
+	conn.uncork();
+	client.waitAll(conn, futures.data(), PIPELINE_SIZE, WAIT_TIMEOUT);
+	for (size_t i = 0; i < PIPELINE_SIZE; ++i) {
+		std::optional<Response<BUFFER>> response =
+			conn.getResponse(futures[i]);
+		fail_unless(response != std::nullopt);
+		fail_unless(response->header.code == 0);
+	}
 	client.close(conn);
 }
 
@@ -191,11 +564,379 @@ many_conn_ping(Connector<BUFFER, NetProvider> &client)
 	(void) conn;
 	fail_unless(conn1.futureIsReady(f1) || conn2.futureIsReady(f2) ||
 		    conn3.futureIsReady(f3));
+	TEST_CASE("Request ids are issued per connection");
+	fail_unless(f1 == 0 && f2 == 0 && f3 == 0);
+	rid_t f4 = conn1.ping();
+	fail_unless(f4 == f1 + 1);
+	client.wait(conn1, f4, WAIT_TIMEOUT);
+	fail_unless(conn1.futureIsReady(f4));
 	client.close(conn1);
 	client.close(conn2);
 	client.close(conn3);
 }
 
+/** Many connections, all ready connections are returned at once. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+many_conn_wait_some(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	using Conn_t = Connection<Buf_t, NetProvider>;
+	const size_t CONN_COUNT = 16;
+	std::vector<std::unique_ptr<Conn_t>> conns;
+	std::vector<rid_t> futures;
+	for (size_t i = 0; i < CONN_COUNT; ++i) {
+		conns.emplace_back(std::make_unique<Conn_t>(client));
+		int rc = client.connect(*conns.back(), localhost, port);
+		fail_unless(rc == 0);
+	}
+	TEST_CASE("Timeout without requests");
+	std::vector<Conn_t *> ready;
+	size_t count = client.waitSome(ready, 100);
+	fail_unless(count == 0 && ready.empty());
+	TEST_CASE("Every ready connection is returned");
+	for (size_t i = 0; i < CONN_COUNT; ++i)
+		futures.push_back(conns[i]->ping());
+	size_t ready_count = 0;
+	while (ready_count < CONN_COUNT) {
+		count = client.waitSome(ready, WAIT_TIMEOUT);
+		fail_unless(count != 0 && count == ready.size());
+		for (Conn_t *conn : ready) {
+			size_t i = 0;
+			while (conns[i].get() != conn)
+				++i;
+			fail_unless(conn->futureIsReady(futures[i]));
+			fail_unless(conn->getResponse(futures[i]) != std::nullopt);
+			ready_count++;
+		}
+	}
+	TEST_CASE("Callback sends next request");
+	for (size_t i = 0; i < CONN_COUNT; ++i)
+		conns[i]->ping();
+	size_t pings = 0;
+	while (pings < 2 * CONN_COUNT) {
+		count = client.waitSome([&](Conn_t &conn) {
+			if (pings++ < CONN_COUNT)
+				conn.ping();
+		}, WAIT_TIMEOUT);
+		fail_unless(count != 0);
+	}
+	fail_unless(client.waitSome(ready, 100) == 0);
+	TEST_CASE("Failed connection is returned, its requests fail");
+	Conn_t &lost = *conns[0];
+	::shutdown(lost.socket, SHUT_RDWR);
+	rid_t f = lost.ping();
+	/* No timeout: wait must not hang on the dead connection. */
+	count = client.waitSome(ready);
+	fail_unless(count == 1 && ready[0] == &lost);
+	fail_unless(lost.status.is_failed);
+	fail_unless(lost.getInFlight() == 0);
+	std::optional<Response<Buf_t>> response = lost.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack != std::nullopt);
+	fail_unless(response->body.error_stack->error.errcode ==
+		    Iproto::ER_NO_CONNECTION);
+	lost.reset();
+	for (size_t i = 0; i < CONN_COUNT; ++i)
+		client.close(*conns[i]);
+}
+
+/** Peer resets one connection while another one is being waited for. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+many_conn_reset(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	using Conn_t = Connection<Buf_t, NetProvider>;
+	/* Listener pretending to be Tarantool: sends greeting and exits. */
+	int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+	fail_unless(listener >= 0);
+	struct sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addr_len = sizeof(addr);
+	fail_unless(::bind(listener, (struct sockaddr *)&addr, addr_len) == 0);
+	fail_unless(::listen(listener, 1) == 0);
+	fail_unless(::getsockname(listener, (struct sockaddr *)&addr,
+				  &addr_len) == 0);
+	Conn_t bad(client);
+	int rc = client.connectAsync(bad, localhost, ntohs(addr.sin_port));
+	fail_unless(rc == 0);
+	int peer = ::accept(listener, nullptr, nullptr);
+	fail_unless(peer >= 0);
+	char greeting[Iproto::GREETING_SIZE];
+	memset(greeting, ' ', sizeof(greeting));
+	const char version[] = "Tarantool 2.10.0 (Binary) "
+		"00000000-0000-0000-0000-000000000000";
+	const char salt[] = "MDEyMzQ1Njc4OWFiY2RlZjAxMjM0NTY3ODlhYmNkZWY=";
+	memcpy(greeting, version, strlen(version));
+	memcpy(greeting + Iproto::GREETING_LINE1_SIZE, salt, strlen(salt));
+	greeting[Iproto::GREETING_LINE1_SIZE - 1] = '\n';
+	greeting[Iproto::GREETING_SIZE - 1] = '\n';
+	fail_unless(::write(peer, greeting, sizeof(greeting)) ==
+		    (ssize_t)sizeof(greeting));
+	rc = client.waitConnect(bad, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	Conn_t good(client);
+	rc = client.connect(good, localhost, port);
+	fail_unless(rc == 0);
+	TEST_CASE("Reset connection is closed, other one is served");
+	rid_t lost = bad.ping();
+	rid_t f = good.ping();
+	rc = client.wait(good, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	good.getResponse(f);
+	/* Zero linger turns close into RST. */
+	struct linger linger = {1, 0};
+	::setsockopt(peer, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+	::close(peer);
+	::close(listener);
+	for (int i = 0; i < 2; ++i) {
+		f = good.ping();
+		rc = client.wait(good, f, WAIT_TIMEOUT);
+		fail_unless(rc == 0);
+		fail_unless(good.getResponse(f) != std::nullopt);
+	}
+	fail_unless(bad.status.is_failed);
+	fail_unless(bad.socket < 0);
+	fail_unless(bad.getError().find("Failed to receive response") == 0);
+	TEST_CASE("Requests of reset connection fail");
+	fail_unless(client.wait(bad, lost, 0) != 0);
+	std::optional<Response<Buf_t>> response = bad.getResponse(lost);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack != std::nullopt);
+	fail_unless(response->body.error_stack->error.errcode ==
+		    Iproto::ER_NO_CONNECTION);
+	bad.reset();
+	client.close(good);
+}
+
+/** Pool of connections, requests are routed to the least loaded one. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+pool_replace(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	using Conn_t = Connection<Buf_t, NetProvider>;
+	ConnectionPool<BUFFER, NetProvider> pool(client);
+	fail_unless(pool.get() == nullptr);
+	int rc = pool.connect(localhost, port, 4);
+	fail_unless(rc == 0);
+	fail_unless(pool.size() == 4);
+	TEST_CASE("Requests are spread evenly");
+	size_t handled = 0;
+	auto handler = [&handled](Response<Buf_t> &response) {
+		fail_unless(response.body.error_stack == std::nullopt);
+		handled++;
+	};
+	for (int i = 0; i < 100; ++i) {
+		Conn_t *conn = pool.get();
+		fail_unless(conn != nullptr);
+		conn->space[512].replace(std::make_tuple(i, "111", 1.01),
+					 handler);
+	}
+	for (size_t i = 0; i < pool.size(); ++i)
+		fail_unless(pool[i].getInFlight() == 25);
+	fail_unless(pool.getInFlight() == 100);
+	rc = pool.waitAll(WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(handled == 100);
+	fail_unless(pool.getInFlight() == 0);
+	TEST_CASE("The least loaded connection is chosen");
+	pool[0].ping();
+	pool[1].ping();
+	pool[3].ping();
+	fail_unless(pool.get() == &pool[2]);
+	rc = pool.waitAll(WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	TEST_CASE("Failed connection is skipped");
+	pool[0].setError("test");
+	for (int i = 0; i < 10; ++i)
+		fail_unless(pool.get() != &pool[0]);
+	pool[0].reset();
+	TEST_CASE("Connection fails while its requests are in flight");
+	size_t lost = 0;
+	handled = 0;
+	auto count_lost = [&](Response<Buf_t> &response) {
+		if (response.body.error_stack != std::nullopt &&
+		    response.body.error_stack->error.errcode ==
+		    Iproto::ER_NO_CONNECTION)
+			lost++;
+		else
+			handled++;
+	};
+	for (int i = 0; i < 8; ++i)
+		pool.get()->ping(count_lost);
+	fail_unless(pool[1].getInFlight() == 2);
+	::shutdown(pool[1].socket, SHUT_RDWR);
+	/* No timeout: the failure must be reported rather than awaited. */
+	rc = pool.waitAll();
+	fail_unless(rc != 0);
+	fail_unless(pool.getInFlight() == 0);
+	fail_unless(lost == 2 && handled == 6);
+	fail_unless(pool[1].status.is_failed);
+	pool[1].reset();
+	pool.close();
+	fail_unless(pool.size() == 0);
+}
+
+/** Data sharded over three instances. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+sharded_replace(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	using Conn_t = Connection<BUFFER, NetProvider>;
+	ShardedClient<BUFFER, NetProvider> sharded(client, 30);
+	fail_unless(sharded.addShard(localhost, port) == 0);
+	for (int shard_port : shard_ports)
+		fail_unless(sharded.addShard(localhost, shard_port) > 0);
+	fail_unless(sharded.addShard(localhost, port + 2) < 0);
+	fail_unless(sharded.shardCount() == 3);
+	TEST_CASE("Buckets are spread evenly");
+	for (uint32_t bucket = 0; bucket < sharded.bucketCount(); ++bucket)
+		fail_unless(sharded.shardOfBucket(bucket) == bucket / 10);
+	TEST_CASE("Requests are routed by key");
+	std::vector<ShardFuture> futures;
+	for (int key = 0; key < 30; ++key) {
+		futures.push_back(sharded.send(key, [&](auto &conn) {
+			return conn.space[512].replace(
+				std::make_tuple(key, "111", 1.01));
+		}));
+		fail_unless(futures.back().shard == sharded.shardOf(key));
+	}
+	for (size_t i = 0; i < sharded.shardCount(); ++i)
+		fail_unless(sharded.shard(i).getInFlight() == 10);
+	int rc = sharded.waitAll(WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	for (const ShardFuture &f : futures) {
+		std::optional<Response<BUFFER>> response =
+			sharded.getResponse(f);
+		fail_unless(response != std::nullopt);
+		fail_unless(response->body.error_stack == std::nullopt);
+	}
+	TEST_CASE("Tuples are stored on their shards");
+	futures.clear();
+	for (int key = 0; key < 30; ++key) {
+		futures.push_back(sharded.send(key, [&](auto &conn) {
+			return conn.space[512].select(std::make_tuple(key));
+		}));
+	}
+	rc = sharded.waitAll(WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	for (int key = 0; key < 30; ++key) {
+		std::optional<Response<BUFFER>> response =
+			sharded.getResponse(futures[key]);
+		fail_unless(response != std::nullopt);
+		fail_unless(response->body.data != std::nullopt);
+		Conn_t &conn = sharded.shard(futures[key].shard);
+		std::vector<UserTuple> tuples =
+			decodeUserTuple(conn.getInBuf(), *response->body.data);
+		fail_unless(tuples.size() == 1);
+		fail_unless(tuples[0].field1 == (uint64_t) key);
+	}
+	TEST_CASE("Bucket is moved to another shard");
+	fail_unless(sharded.shardOf(0) == 0);
+	sharded.setRoute(sharded.bucketOf(0), 2);
+	fail_unless(sharded.shardOf(0) == 2);
+	fail_unless(&sharded.route(0) == &sharded.shard(2));
+	TEST_CASE("Moved bucket stays on its shard when a shard is added");
+	uint32_t moved = sharded.bucketOf(0);
+	fail_unless(sharded.addShard(localhost, port) == 3);
+	fail_unless(sharded.shardOfBucket(moved) == 2);
+	for (uint32_t bucket = 0; bucket < sharded.bucketCount(); ++bucket) {
+		if (bucket != moved)
+			fail_unless(sharded.shardOfBucket(bucket) ==
+				    bucket * 4 / sharded.bucketCount());
+	}
+	sharded.close();
+}
+
+/** Select from several instances merged in order of primary key. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+scatter_select(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	using Conn_t = Connection<BUFFER, NetProvider>;
+	Conn_t conn1(client);
+	Conn_t conn2(client);
+	Conn_t conn3(client);
+	Conn_t *conns[] = {&conn1, &conn2, &conn3};
+	int rc = client.connect(conn1, localhost, port);
+	fail_unless(rc == 0);
+	for (size_t i = 0; i < 2; ++i) {
+		rc = client.connect(*conns[i + 1], localhost, shard_ports[i]);
+		fail_unless(rc == 0);
+	}
+	/* Keys of this test do not intersect with keys of others. */
+	const uint64_t FIRST_KEY = 100000;
+	for (uint64_t key = FIRST_KEY; key < FIRST_KEY + 30; ++key) {
+		Conn_t &conn = *conns[key % 3];
+		rid_t f = conn.space[512].replace(
+			std::make_tuple(key, "111", 1.01));
+		client.wait(conn, f, WAIT_TIMEOUT);
+		fail_unless(conn.getResponse(f) != std::nullopt);
+	}
+	auto key_of = [](Conn_t &conn, Tuple<BUFFER> &t) {
+		UserTuple tuple;
+		mpp::Dec dec(conn.getInBuf());
+		dec.SetPosition(t.begin);
+		dec.SetReader(false, ArrayReader<BUFFER>{dec, tuple});
+		dec.Read();
+		return tuple.field1;
+	};
+	std::vector<uint64_t> keys;
+	auto collect = [&](Conn_t &conn, Tuple<BUFFER> &t) {
+		keys.push_back(key_of(conn, t));
+	};
+	ScatterSelect<BUFFER, NetProvider> select(client);
+
+	TEST_CASE("Ascending order with global offset and limit");
+	rc = select.execute(conns, 3, 512, 0, std::make_tuple(FIRST_KEY),
+			    10, 5, GE, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(select.merge(key_of, collect) == 10);
+	fail_unless(keys.size() == 10);
+	for (size_t i = 0; i < keys.size(); ++i)
+		fail_unless(keys[i] == FIRST_KEY + 5 + i);
+
+	TEST_CASE("Descending order");
+	keys.clear();
+	rc = select.execute(conns, 3, 512, 0, std::make_tuple(FIRST_KEY + 29),
+			    5, 0, LE, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(select.merge(key_of, collect) == 5);
+	for (size_t i = 0; i < keys.size(); ++i)
+		fail_unless(keys[i] == FIRST_KEY + 29 - i);
+
+	TEST_CASE("Error of one of connections");
+	rc = select.execute(conns, 3, 666, 0, std::make_tuple(FIRST_KEY),
+			    10, 0, GE, WAIT_TIMEOUT);
+	fail_unless(rc != 0);
+	fail_unless(! select.getError().empty());
+
+	TEST_CASE("Timeout of one of connections");
+	/* Select to the corked connection is held until uncork(). */
+	conn2.cork();
+	rc = select.execute(conns, 3, 512, 0, std::make_tuple(FIRST_KEY),
+			    10, 0, GE, 100);
+	fail_unless(rc != 0);
+	fail_unless(! select.getError().empty());
+	conn2.uncork();
+	/* Late responses of the select are dropped once decoded. */
+	for (Conn_t *conn : conns) {
+		rid_t f = conn->ping();
+		rc = client.wait(*conn, f, WAIT_TIMEOUT);
+		fail_unless(rc == 0);
+		fail_unless(conn->getResponse(f) != std::nullopt);
+		fail_unless(conn->getInFlight() == 0);
+		fail_unless(conn->getReadyCount() == 0);
+	}
+	for (Conn_t *conn : conns)
+		client.close(*conn);
+}
+
 /** Single connection, errors in response. */
 template <class BUFFER, class NetProvider = Net_t>
 void
@@ -557,17 +1298,387 @@ single_conn_call(Connector<BUFFER, NetProvider> &client)
 	client.close(conn);
 }
 
+/** Single connection, spaces and indexes accessed by names. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_schema(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<Buf_t, NetProvider> conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+
+	TEST_CASE("Fetch schema");
+	fail_unless(conn.getSchema().getVersion() == 0);
+	rid_t f = conn.loadSchema();
+	rc = client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	const Schema &schema = conn.getSchema();
+	fail_unless(schema.getVersion() != 0);
+	fail_unless(schema.findSpace("T") == 512u);
+	fail_unless(schema.findSpace("_vspace") == Schema::VSPACE_ID);
+	fail_unless(schema.findIndex(512, "primary") == 0u);
+	fail_unless(schema.findSpace("no_such_space") == std::nullopt);
+	fail_unless(schema.findIndex(512, "no_such_index") == std::nullopt);
+
+	TEST_CASE("Requests by names");
+	f = conn.space["T"].replace(std::make_tuple(50, "by name", 5.0));
+	client.wait(conn, f, WAIT_TIMEOUT);
+	std::optional<Response<Buf_t>> response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack == std::nullopt);
+	f = conn.space["T"].index["primary"].select(std::make_tuple(50));
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.data->tuples.size() == 1);
+	f = conn.space["no_such_space"].select(std::make_tuple(50));
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack != std::nullopt);
+
+	TEST_CASE("Schema is refreshed after change");
+	uint64_t version = schema.getVersion();
+	f = conn.eval("box.schema.space.create('schema_test')",
+		      std::make_tuple());
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack == std::nullopt);
+	/* Request sent before the schema is re-fetched is not rejected. */
+	f = conn.space[512].select(std::make_tuple(50));
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack == std::nullopt);
+	for (int i = 0; i < 10 && schema.getVersion() == version; i++) {
+		f = conn.ping();
+		client.wait(conn, f, WAIT_TIMEOUT);
+		conn.getResponse(f);
+	}
+	fail_unless(schema.getVersion() != version);
+	fail_unless(schema.findSpace("schema_test") != std::nullopt);
+	f = conn.eval("box.space.schema_test:drop()", std::make_tuple());
+	client.wait(conn, f, WAIT_TIMEOUT);
+	conn.getResponse(f);
+
+	client.close(conn);
+}
+
+/** Single connection, interactive transactions in streams. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_stream(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	using Conn_t = Connection<Buf_t, NetProvider>;
+	Conn_t conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+	typename Conn_t::Stream s1 = conn.openStream();
+	typename Conn_t::Stream s2 = conn.openStream();
+	fail_unless(s1.getId() != 0 && s1.getId() != s2.getId());
+
+	TEST_CASE("Interleaved transactions");
+	rid_t futures[6];
+	futures[0] = s1.begin();
+	futures[1] = s2.begin(10, Iproto::TXN_ISOLATION_READ_COMMITTED);
+	futures[2] = s1.space[512].replace(std::make_tuple(40, "s1", 1.0));
+	futures[3] = s2.space[512].replace(std::make_tuple(41, "s2", 2.0));
+	futures[4] = s1.commit();
+	futures[5] = s2.rollback();
+	client.waitAll(conn, futures, 6, WAIT_TIMEOUT);
+	for (rid_t f : futures) {
+		std::optional<Response<Buf_t>> response = conn.getResponse(f);
+		fail_unless(response != std::nullopt);
+		fail_unless(response->body.error_stack == std::nullopt);
+	}
+	rid_t f1 = conn.space[512].select(std::make_tuple(40));
+	rid_t f2 = conn.space[512].select(std::make_tuple(41));
+	client.wait(conn, f2, WAIT_TIMEOUT);
+	std::optional<Response<Buf_t>> response = conn.getResponse(f1);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.data->tuples.size() == 1);
+	response = conn.getResponse(f2);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.data->tuples.size() == 0);
+
+	TEST_CASE("Commit without transaction fails");
+	rid_t f3 = s1.commit();
+	client.wait(conn, f3, WAIT_TIMEOUT);
+	response = conn.getResponse(f3);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack != std::nullopt);
+
+	client.close(conn);
+}
+
+/** Single connection, EVAL of runtime and compile-time expressions. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_eval(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<Buf_t, NetProvider> conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+
+	TEST_CASE("Runtime expression");
+	rid_t f1 = conn.eval("return ...", std::make_tuple(1, "two", 3.3));
+	TEST_CASE("Compile-time expression");
+	rid_t f2 = conn.eval(MPP_AS_CONSTR("return box.space.T:select()"),
+			     std::make_tuple());
+	TEST_CASE("Erroneous expression");
+	rid_t f3 = conn.eval("error('oops')", std::make_tuple());
+	rid_t futures[] = {f1, f2, f3};
+	client.waitAll(conn, futures, 3, WAIT_TIMEOUT);
+
+	std::optional<Response<Buf_t>> response = conn.getResponse(f1);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.data != std::nullopt);
+	fail_unless(response->body.error_stack == std::nullopt);
+	printResponse<BUFFER, NetProvider>(conn, *response, MULTI_RETURN);
+	response = conn.getResponse(f2);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.data != std::nullopt);
+	printResponse<BUFFER, NetProvider>(conn, *response, SELECT_RETURN);
+	response = conn.getResponse(f3);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack != std::nullopt);
+
+	client.close(conn);
+}
+
+/** Single connection, SQL requests and statement cache. */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_sql(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	Connection<Buf_t, NetProvider> conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+
+	TEST_CASE("Execute SQL text");
+	rid_t f = conn.execute("REPLACE INTO T VALUES (?, ?, ?)",
+			       std::make_tuple(20, "sql", 2.5));
+	client.wait(conn, f, WAIT_TIMEOUT);
+	std::optional<Response<Buf_t>> response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack == std::nullopt);
+	fail_unless(response->body.sql_info != std::nullopt);
+	fail_unless(response->body.sql_info->row_count == 1);
+
+	f = conn.execute("SELECT * FROM T WHERE \"id\" = ?",
+			 std::make_tuple(20));
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.metadata != std::nullopt);
+	fail_unless(response->body.metadata->size() == 3);
+	fail_unless((*response->body.metadata)[0].field_name == "id");
+	fail_unless(response->body.data != std::nullopt);
+	fail_unless(response->body.data->tuples.size() == 1);
+
+	TEST_CASE("Prepare and execute by id");
+	f = conn.prepare("SELECT * FROM T WHERE \"id\" = ?");
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.stmt_id != std::nullopt);
+	fail_unless(response->body.bind_count == 1u);
+	uint32_t stmt_id = *response->body.stmt_id;
+	f = conn.execute(stmt_id, std::make_tuple(20));
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.data != std::nullopt);
+	fail_unless(response->body.data->tuples.size() == 1);
+	f = conn.unprepare(stmt_id);
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->header.code == 0);
+
+	TEST_CASE("Statement cache");
+	const char *query = "SELECT \"a\" FROM T WHERE \"id\" = ?";
+	const LatencyHistogram *prepares = conn.getLatency(Iproto::PREPARE);
+	size_t prepare_count = prepares != nullptr ? prepares->count() : 0;
+	for (int i = 0; i < 3; i++) {
+		f = conn.executeCached(query, std::make_tuple(20));
+		client.wait(conn, f, WAIT_TIMEOUT);
+		response = conn.getResponse(f);
+		fail_unless(response != std::nullopt);
+		fail_unless(response->body.error_stack == std::nullopt);
+		fail_unless(response->body.data->tuples.size() == 1);
+	}
+	prepares = conn.getLatency(Iproto::PREPARE);
+	fail_unless(prepares != nullptr);
+	fail_unless(prepares->count() == prepare_count + 1);
+
+	TEST_CASE("Evicted statement is unprepared");
+	conn.setStatementCacheSize(0);
+	f = conn.executeCached(query, std::make_tuple(20));
+	client.wait(conn, f, WAIT_TIMEOUT);
+	fail_unless(conn.getResponse(f) != std::nullopt);
+	fail_unless(conn.getLatency(Iproto::PREPARE)->count() ==
+		    prepare_count + 2);
+	fail_unless(conn.getInFlight() == 0);
+
+	TEST_CASE("SQL error");
+	f = conn.execute("SELECT * FROM no_such_table", std::make_tuple());
+	client.wait(conn, f, WAIT_TIMEOUT);
+	response = conn.getResponse(f);
+	fail_unless(response != std::nullopt);
+	fail_unless(response->body.error_stack != std::nullopt);
+
+	client.close(conn);
+}
+
+/** Single connection, responses are consumed by handlers */
+template <class BUFFER, class NetProvider = Net_t>
+void
+single_conn_handler(Connector<BUFFER, NetProvider> &client)
+{
+	TEST_INIT(0);
+	using Conn_t = Connection<Buf_t, NetProvider>;
+	Conn_t conn(client);
+	int rc = client.connect(conn, localhost, port);
+	fail_unless(rc == 0);
+
+	TEST_CASE("Handlers of different requests");
+	size_t handled = 0;
+	rid_t last_sync = 0;
+	auto check_data = [&](Response<Buf_t> &response) {
+		fail_unless(response.body.data != std::nullopt);
+		fail_unless(response.body.error_stack == std::nullopt);
+		last_sync = response.header.sync;
+		handled++;
+	};
+	rid_t f1 = conn.space[512].replace(std::make_tuple(1, "111", 1.01),
+					   check_data);
+	rid_t f2 = conn.space[512].select(std::make_tuple(1), check_data);
+	rid_t f3 = conn.space[512].index[0].select(std::make_tuple(1),
+						   check_data);
+	rid_t f4 = conn.call("remote_uint", std::make_tuple(), check_data);
+	rid_t f5 = conn.ping([&](Response<Buf_t> &response) {
+		fail_unless(response.header.code == 0);
+		handled++;
+	});
+	rid_t futures[] = {f1, f2, f3, f4, f5};
+	client.waitAll(conn, futures, 5, WAIT_TIMEOUT);
+	fail_unless(handled == 5);
+	fail_unless(last_sync == f4);
+	for (rid_t f : futures) {
+		fail_unless(!conn.futureIsReady(f));
+		fail_unless(conn.getResponse(f) == std::nullopt);
+	}
+
+	TEST_CASE("Error response is passed to handler");
+	rid_t f6 = conn.call("wrong_name", std::make_tuple(),
+			     [&](Response<Buf_t> &response) {
+		fail_unless(response.body.error_stack != std::nullopt);
+		handled++;
+	});
+	rc = client.wait(conn, f6, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(handled == 6);
+
+	TEST_CASE("Handler of already decoded response is called at once");
+	rid_t f7 = conn.ping();
+	client.wait(conn, f7, WAIT_TIMEOUT);
+	fail_unless(conn.futureIsReady(f7));
+	conn.onResponse(f7, [&](Response<Buf_t> &) { handled++; });
+	fail_unless(handled == 7);
+	fail_unless(!conn.futureIsReady(f7));
+
+	TEST_CASE("Handler issues continuation request");
+	rid_t next = 0;
+	rid_t f8 = conn.ping([&](Response<Buf_t> &) {
+		next = conn.space[512].select(std::make_tuple(1));
+	});
+	client.wait(conn, f8, WAIT_TIMEOUT);
+	fail_unless(next != 0);
+	client.wait(conn, next, WAIT_TIMEOUT);
+	fail_unless(conn.futureIsReady(next));
+	fail_unless(conn.getResponse(next) != std::nullopt);
+
+	TEST_CASE("Handled request is in flight until handler is called");
+	size_t in_flight = SIZE_MAX;
+	rid_t f9 = conn.ping([&](Response<Buf_t> &) {
+		in_flight = conn.getInFlight();
+	});
+	fail_unless(conn.getInFlight() == 1);
+	rc = client.wait(conn, f9, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(in_flight == 0);
+
+	TEST_CASE("Deadline of handled request");
+	conn.cork();
+	bool is_expired = false;
+	rid_t f10 = conn.ping([&](Response<Buf_t> &response) {
+		is_expired = response.header.code ==
+			     (Iproto::TYPE_ERROR | (int) Iproto::ER_TIMEOUT);
+	});
+	conn.setDeadline(f10, std::chrono::steady_clock::now() +
+			      std::chrono::milliseconds(10));
+	rc = client.wait(conn, f10, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(is_expired);
+	conn.uncork();
+
+	TEST_CASE("Response of dropped handler is stored");
+	rid_t f11 = conn.ping([&](Response<Buf_t> &) { handled++; });
+	conn.dropHandler(f11);
+	rc = client.wait(conn, f11, WAIT_TIMEOUT);
+	fail_unless(rc == 0);
+	fail_unless(conn.getResponse(f11) != std::nullopt);
+	fail_unless(handled == 7);
+	fail_unless(conn.getInFlight() == 0);
+
+	TEST_CASE("Handled request fails when connection is lost");
+	bool is_lost = false;
+	rid_t f12 = conn.ping([&](Response<Buf_t> &response) {
+		is_lost = response.body.error_stack != std::nullopt &&
+			  response.body.error_stack->error.errcode ==
+			  Iproto::ER_NO_CONNECTION;
+	});
+	::shutdown(conn.socket, SHUT_RDWR);
+	client.wait(conn, f12, WAIT_TIMEOUT);
+	fail_unless(is_lost);
+	fail_unless(conn.getInFlight() == 0);
+	conn.reset();
+
+	client.close(conn);
+}
+
 int main()
 {
 	if (cleanDir() != 0)
 		return -1;
 	if (launchTarantool() != 0)
 		return -1;
+	for (int shard_port : shard_ports) {
+		if (launchTarantool(shard_port) != 0)
+			return -1;
+	}
 	sleep(1);
 	Connector<Buf_t> client;
 	trivial(client);
 	single_conn_ping<Buf_t>(client);
+	single_conn_flush<Buf_t>(client);
+	single_conn_reconnect<Buf_t>(client);
+	single_conn_deadline<Buf_t>(client);
+	single_conn_auth<Buf_t>(client);
+	single_conn_stats<Buf_t>(client);
 	many_conn_ping<Buf_t>(client);
+	many_conn_wait_some<Buf_t>(client);
+	many_conn_reset<Buf_t>(client);
+	many_conn_connect_async<Buf_t>(client);
+	pool_replace<Buf_t>(client);
+	sharded_replace<Buf_t>(client);
+	scatter_select<Buf_t>(client);
 	single_conn_error<Buf_t>(client);
 	single_conn_replace<Buf_t>(client);
 	single_conn_insert<Buf_t>(client);
@@ -576,13 +1687,48 @@ int main()
 	single_conn_upsert<Buf_t>(client);
 	single_conn_select<Buf_t>(client);
 	single_conn_call<Buf_t>(client);
+	single_conn_eval<Buf_t>(client);
+	single_conn_stream<Buf_t>(client);
+	single_conn_schema<Buf_t>(client);
+	single_conn_sql<Buf_t>(client);
+	single_conn_handler<Buf_t>(client);
+
+	/* Default network provider in edge-triggered mode. */
+	Connector<Buf_t> et_client;
+	et_client.getNetProvider().setEdgeTriggered(true);
+	single_conn_ping<Buf_t>(et_client);
+	many_conn_ping<Buf_t>(et_client);
+	many_conn_connect_async<Buf_t>(et_client);
+	many_conn_reset<Buf_t>(et_client);
+	single_conn_error<Buf_t>(et_client);
+	single_conn_replace<Buf_t>(et_client);
+	single_conn_select<Buf_t>(et_client);
+	single_conn_call<Buf_t>(et_client);
+
+	/* Small buffer blocks: requests are sent with many iovecs. */
+	using SmallBuf_t = tnt::Buffer<128>;
+	Connector<SmallBuf_t, DefaultNetProvider<SmallBuf_t, NetworkEngine>>
+		small_client;
+	single_conn_pipeline(small_client);
+	Connector<SmallBuf_t, LibevNetProvider<SmallBuf_t, NetworkEngine>>
+		small_ev_client;
+	single_conn_pipeline(small_ev_client);
 
 	/* LibEv network provide */
 	using NetLibEv_t = LibevNetProvider<Buf_t, NetworkEngine>;
 	Connector<Buf_t, NetLibEv_t > another_client;
 	trivial<Buf_t, NetLibEv_t >(another_client);
 	single_conn_ping<Buf_t, NetLibEv_t>(another_client);
+	single_conn_flush<Buf_t, NetLibEv_t>(another_client);
+	single_conn_reconnect<Buf_t, NetLibEv_t>(another_client);
+	single_conn_deadline<Buf_t, NetLibEv_t>(another_client);
+	single_conn_auth<Buf_t, NetLibEv_t>(another_client);
+	single_conn_stats<Buf_t, NetLibEv_t>(another_client);
 	many_conn_ping<Buf_t, NetLibEv_t>(another_client);
+	many_conn_wait_some<Buf_t, NetLibEv_t>(another_client);
+	many_conn_reset<Buf_t, NetLibEv_t>(another_client);
+	many_conn_connect_async<Buf_t, NetLibEv_t>(another_client);
+	pool_replace<Buf_t, NetLibEv_t>(another_client);
 	single_conn_error<Buf_t, NetLibEv_t>(another_client);
 	single_conn_replace<Buf_t, NetLibEv_t>(another_client);
 	single_conn_insert<Buf_t, NetLibEv_t>(another_client);
@@ -591,5 +1737,33 @@ int main()
 	single_conn_upsert<Buf_t, NetLibEv_t>(another_client);
 	single_conn_select<Buf_t, NetLibEv_t>(another_client);
 	single_conn_call<Buf_t, NetLibEv_t>(another_client);
+	single_conn_eval<Buf_t, NetLibEv_t>(another_client);
+	single_conn_stream<Buf_t, NetLibEv_t>(another_client);
+	single_conn_schema<Buf_t, NetLibEv_t>(another_client);
+	single_conn_sql<Buf_t, NetLibEv_t>(another_client);
+	single_conn_handler<Buf_t, NetLibEv_t>(another_client);
+
+#ifdef TNTCXX_ENABLE_URING
+	/* io_uring network provider */
+	using NetUring_t = UringNetProvider<Buf_t, NetworkEngine>;
+	Connector<Buf_t, NetUring_t > uring_client;
+	trivial<Buf_t, NetUring_t >(uring_client);
+	single_conn_ping<Buf_t, NetUring_t>(uring_client);
+	single_conn_flush<Buf_t, NetUring_t>(uring_client);
+	single_conn_stats<Buf_t, NetUring_t>(uring_client);
+	single_conn_pipeline(uring_client);
+	single_conn_reconnect<Buf_t, NetUring_t>(uring_client);
+	many_conn_ping<Buf_t, NetUring_t>(uring_client);
+	many_conn_connect_async<Buf_t, NetUring_t>(uring_client);
+	single_conn_error<Buf_t, NetUring_t>(uring_client);
+	single_conn_replace<Buf_t, NetUring_t>(uring_client);
+	single_conn_insert<Buf_t, NetUring_t>(uring_client);
+	single_conn_update<Buf_t, NetUring_t>(uring_client);
+	single_conn_delete<Buf_t, NetUring_t>(uring_client);
+	single_conn_upsert<Buf_t, NetUring_t>(uring_client);
+	single_conn_select<Buf_t, NetUring_t>(uring_client);
+	single_conn_call<Buf_t, NetUring_t>(uring_client);
+	single_conn_handler<Buf_t, NetUring_t>(uring_client);
+#endif
 	return 0;
 }
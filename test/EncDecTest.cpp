@@ -330,9 +330,34 @@ test_basic()
 	}
 }
 
+/** Tuples with constants are encoded in line with compile-time headers. */
+void
+test_const_tuple()
+{
+	TEST_INIT(0);
+	using Buf_t = tnt::Buffer<16 * 1024>;
+	Buf_t buf;
+	mpp::Enc<Buf_t> enc(buf);
+	int runtime = 5;
+	enc.add(mpp::as_map(std::forward_as_tuple(
+		MPP_AS_CONST(0x27), MPP_AS_CONSTR("return ..."),
+		MPP_AS_CONST(0x21), std::make_tuple(runtime, MPP_AS_CONST(6)))),
+		MPP_AS_CONST(7));
+	enc.add(std::make_tuple(), std::make_tuple(std::make_tuple(1)));
+	const char expected[] = "\x82\x27\xaareturn ...\x21\x92\x05\x06\x07"
+				"\x90\x91\x91\x01";
+	size_t size = sizeof(expected) - 1;
+	fail_unless((size_t) (buf.end() - buf.begin()) == size);
+	char actual[sizeof(expected)];
+	auto itr = buf.begin();
+	buf.get(itr, actual, size);
+	fail_unless(memcmp(actual, expected, size) == 0);
+}
+
 int main()
 {
 	test_static_assert();
 	test_type_visual();
 	test_basic();
+	test_const_tuple();
 }
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include "../src/Utils/Histogram.hpp"
+
+#include "Utils/Helpers.hpp"
+
+using Histogram_t = tnt::Histogram<>;
+
+static void
+buckets()
+{
+	TEST_INIT(0);
+	TEST_CASE("Small values are exact");
+	for (uint64_t v = 0; v < 32; ++v) {
+		fail_unless(Histogram_t::bucketIndex(v) == v);
+		fail_unless(Histogram_t::bucketUpperBound(v) == v);
+	}
+	TEST_CASE("Buckets are contiguous and bounds are tight");
+	size_t prev = Histogram_t::bucketIndex(31);
+	for (uint64_t v = 32; v < (1 << 20); ++v) {
+		size_t idx = Histogram_t::bucketIndex(v);
+		fail_unless(idx == prev || idx == prev + 1);
+		if (idx != prev)
+			fail_unless(Histogram_t::bucketUpperBound(prev) == v - 1);
+		/* Relative error is bounded by precision. */
+		uint64_t upper = Histogram_t::bucketUpperBound(idx);
+		fail_unless(upper >= v);
+		fail_unless(upper - v <= v / 16);
+		prev = idx;
+	}
+	TEST_CASE("Huge values go to the last bucket");
+	fail_unless(Histogram_t::bucketIndex((uint64_t{1} << 40) - 1) ==
+		    Histogram_t::BUCKET_COUNT - 2);
+	fail_unless(Histogram_t::bucketIndex(uint64_t{1} << 40) ==
+		    Histogram_t::BUCKET_COUNT - 1);
+	fail_unless(Histogram_t::bucketIndex(UINT64_MAX) ==
+		    Histogram_t::BUCKET_COUNT - 1);
+}
+
+static void
+percentiles()
+{
+	TEST_INIT(0);
+	Histogram_t hist;
+	fail_unless(hist.count() == 0);
+	fail_unless(hist.percentile(50) == 0);
+	fail_unless(hist.min() == 0 && hist.max() == 0 && hist.mean() == 0);
+	for (uint64_t v = 1; v <= 1000; ++v)
+		hist.record(v * 1000);
+	fail_unless(hist.count() == 1000);
+	fail_unless(hist.min() == 1000);
+	fail_unless(hist.max() == 1000000);
+	fail_unless(hist.mean() == 500500);
+	uint64_t p50 = hist.percentile(50);
+	fail_unless(p50 >= 500000 && p50 <= 500000 + 500000 / 16);
+	uint64_t p99 = hist.percentile(99);
+	fail_unless(p99 >= 990000 && p99 <= 990000 + 990000 / 16);
+	fail_unless(hist.percentile(100) == 1000000);
+	fail_unless(hist.percentile(0) <= 1000 + 1000 / 16);
+	TEST_CASE("Merge");
+	Histogram_t other;
+	other.record(7);
+	other.record(UINT64_MAX);
+	hist.merge(other);
+	fail_unless(hist.count() == 1002);
+	fail_unless(hist.min() == 7);
+	fail_unless(hist.max() == UINT64_MAX);
+	fail_unless(hist.percentile(0) == 7);
+	fail_unless(hist.percentile(100) == UINT64_MAX);
+	TEST_CASE("Reset");
+	hist.reset();
+	fail_unless(hist.count() == 0);
+	fail_unless(hist.percentile(99) == 0);
+}
+
+int main()
+{
+	buckets();
+	percentiles();
+	return 0;
+}
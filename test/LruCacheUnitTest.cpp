@@ -0,0 +1,133 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+
+#include "../src/Utils/LruCache.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Utils/Helpers.hpp"
+
+static void
+simple()
+{
+	TEST_INIT(0);
+	tnt::LruCache<std::string, int> cache(2);
+	std::vector<std::string> evicted;
+	auto on_evict = [&](const std::string &key, int) {
+		evicted.push_back(key);
+	};
+	fail_unless(cache.find("a") == nullptr);
+	cache.insert("a", 1, on_evict);
+	cache.insert("b", 2, on_evict);
+	fail_unless(cache.size() == 2);
+	TEST_CASE("find() makes entry the most recently used");
+	fail_unless(*cache.find("a") == 1);
+	cache.insert("c", 3, on_evict);
+	fail_unless(evicted.size() == 1 && evicted[0] == "b");
+	fail_unless(cache.find("b") == nullptr);
+	TEST_CASE("peek() does not affect eviction order");
+	fail_unless(*cache.peek("a") == 1);
+	cache.insert("d", 4, on_evict);
+	fail_unless(evicted.size() == 2 && evicted[1] == "a");
+	TEST_CASE("Replacement does not evict");
+	cache.insert("c", 33, on_evict);
+	fail_unless(evicted.size() == 2);
+	fail_unless(*cache.find("c") == 33);
+	TEST_CASE("Shrink");
+	cache.setCapacity(1, on_evict);
+	fail_unless(evicted.size() == 3 && evicted[2] == "d");
+	fail_unless(cache.size() == 1);
+	fail_unless(cache.erase("c"));
+	fail_unless(! cache.erase("c"));
+	fail_unless(cache.size() == 0);
+	cache.insert("e", 5, on_evict);
+	cache.clear();
+	fail_unless(cache.size() == 0 && cache.find("e") == nullptr);
+	fail_unless(evicted.size() == 3);
+}
+
+/** Compare against straightforward model: key -> (value, last use). */
+static void
+random_ops(size_t capacity, size_t key_count, size_t op_count)
+{
+	TEST_INIT(3, capacity, key_count, op_count);
+	tnt::LruCache<int, int> cache(capacity);
+	std::map<int, std::pair<int, size_t>> model;
+	for (size_t op = 0; op < op_count; op++) {
+		int key = rand() % key_count;
+		auto itr = model.find(key);
+		if (rand() % 2 == 0) {
+			int *value = cache.find(key);
+			fail_unless((value == nullptr) == (itr == model.end()));
+			if (value == nullptr)
+				continue;
+			fail_unless(*value == itr->second.first);
+			itr->second.second = op;
+			continue;
+		}
+		int value = rand();
+		int victim = -1;
+		if (itr == model.end() && model.size() == capacity) {
+			size_t oldest = SIZE_MAX;
+			for (auto &m : model) {
+				if (m.second.second < oldest) {
+					oldest = m.second.second;
+					victim = m.first;
+				}
+			}
+		}
+		size_t evicted = 0;
+		cache.insert(key, value, [&](int k, int v) {
+			fail_unless(k == victim);
+			fail_unless(v == model[k].first);
+			evicted++;
+		});
+		fail_unless(evicted == (victim >= 0 ? 1 : 0));
+		if (victim >= 0)
+			model.erase(victim);
+		model[key] = {value, op};
+		fail_unless(cache.size() == model.size());
+	}
+}
+
+int main()
+{
+	simple();
+	random_ops(1, 4, 1000);
+	random_ops(16, 32, 100000);
+	random_ops(100, 1000, 100000);
+	return 0;
+}
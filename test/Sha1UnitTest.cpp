@@ -0,0 +1,103 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include "../src/Utils/Sha1.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "Utils/Helpers.hpp"
+
+static std::string
+toHex(const uint8_t *digest)
+{
+	const char *hex = "0123456789abcdef";
+	std::string res;
+	for (size_t i = 0; i < sha1::DIGEST_SIZE; ++i) {
+		res.push_back(hex[digest[i] / 16]);
+		res.push_back(hex[digest[i] % 16]);
+	}
+	return res;
+}
+
+static std::string
+digestHex(const std::string &data)
+{
+	uint8_t digest[sha1::DIGEST_SIZE];
+	sha1::digest(data.data(), data.size(), digest);
+	return toHex(digest);
+}
+
+/* Test vectors of FIPS 180 and RFC 3174. */
+static void
+known_digests()
+{
+	TEST_INIT(0);
+	fail_unless(digestHex("") ==
+		    "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+	fail_unless(digestHex("abc") ==
+		    "a9993e364706816aba3e25717850c26c9cd0d89d");
+	fail_unless(digestHex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+		    "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+	fail_unless(digestHex(std::string(1000000, 'a')) ==
+		    "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+	fail_unless(digestHex("The quick brown fox jumps over the lazy dog") ==
+		    "2fd4e1c67a2d28fced849ee1bb76e7391b93eb12");
+}
+
+/* Digest doesn't depend on how data is split into update() calls. */
+static void
+split_updates()
+{
+	TEST_INIT(0);
+	std::string data;
+	for (size_t i = 0; i < 300; ++i)
+		data.push_back((char) (i * 7));
+	for (size_t len = 0; len <= data.size(); len += 13) {
+		std::string whole = digestHex(data.substr(0, len));
+		for (size_t step = 1; step <= 130; step += 17) {
+			sha1::Context ctx;
+			for (size_t pos = 0; pos < len; pos += step)
+				ctx.update(data.data() + pos,
+					   std::min(step, len - pos));
+			uint8_t digest[sha1::DIGEST_SIZE];
+			ctx.finish(digest);
+			fail_unless(toHex(digest) == whole);
+		}
+	}
+}
+
+int main()
+{
+	known_digests();
+	split_updates();
+}
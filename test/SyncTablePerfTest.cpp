@@ -0,0 +1,136 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <optional>
+#include <unordered_map>
+
+#include "Utils/Out.hpp"
+#include "Utils/PerfTimer.hpp"
+#include "../src/Buffer/Buffer.hpp"
+#include "../src/Client/ResponseReader.hpp"
+#include "../src/Utils/SyncTable.hpp"
+
+/** Total count of requests processed in each bench. */
+constexpr size_t TOTAL = 8 * 1024 * 1024;
+
+/** Decoded response, the same one Connection stores in its futures. */
+using Payload = Response<tnt::Buffer<16 * 1024>>;
+
+/** Adapter of std::unordered_map to SyncTable API. */
+struct HashTable {
+	void insert(size_t key, Payload &&value)
+	{
+		m_Map.emplace(key, std::move(value));
+	}
+	Payload *find(size_t key)
+	{
+		auto itr = m_Map.find(key);
+		return itr == m_Map.end() ? nullptr : &itr->second;
+	}
+	std::optional<Payload> take(size_t key)
+	{
+		auto itr = m_Map.find(key);
+		if (itr == m_Map.end())
+			return std::nullopt;
+		std::optional<Payload> res = std::move(itr->second);
+		m_Map.erase(itr);
+		return res;
+	}
+	std::unordered_map<size_t, Payload> m_Map;
+};
+
+static const char *
+tableName(const HashTable &)
+{
+	return "std::unordered_map";
+}
+
+static const char *
+tableName(const tnt::SyncTable<Payload> &)
+{
+	return "tnt::SyncTable";
+}
+
+/**
+ * Emulate a connection with @a in_flight pending requests: responses to
+ * a batch of requests are inserted, checked for readiness and taken.
+ */
+template <class TABLE>
+__attribute__((noinline)) void
+bench(size_t in_flight)
+{
+	TABLE table;
+	std::cout << "---------------------------------------" << std::endl;
+	std::cout << "Bench of " << tableName(table) << " with " << in_flight
+		  << " requests in flight, response is " << sizeof(Payload)
+		  << " bytes" << std::endl;
+	PerfTimer insert_timer, find_timer, take_timer;
+	double insert_time = 0, find_time = 0, take_time = 0;
+	size_t sync = 0;
+	size_t checksum = 0;
+	for (size_t round = 0; round < TOTAL / in_flight; ++round) {
+		size_t batch_start = sync;
+		insert_timer.start();
+		for (size_t i = 0; i < in_flight; ++i, ++sync) {
+			Payload payload{};
+			payload.header.sync = sync;
+			table.insert(sync, std::move(payload));
+		}
+		insert_timer.stop();
+		find_timer.start();
+		for (size_t i = batch_start; i < sync; ++i)
+			checksum += table.find(i) != nullptr;
+		find_timer.stop();
+		take_timer.start();
+		for (size_t i = batch_start; i < sync; ++i)
+			checksum += table.take(i)->header.sync;
+		take_timer.stop();
+		insert_time += insert_timer.result();
+		find_time += find_timer.result();
+		take_time += take_timer.result();
+	}
+	OUT(insert_time, find_time, take_time);
+	std::cout << "Total Mrps " << TOTAL / (insert_time + find_time + take_time) / 1000000
+		  << std::endl;
+	/* Make sure that the work is not optimized out. */
+	if (checksum == 0)
+		std::cout << "FAILURE: wrong checksum!" << std::endl;
+}
+
+int main()
+{
+	for (size_t in_flight : {2 * 1024, 64 * 1024, 1024 * 1024}) {
+		bench<HashTable>(in_flight);
+		bench<tnt::SyncTable<Payload>>(in_flight);
+	}
+	return 0;
+}
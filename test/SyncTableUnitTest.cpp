@@ -0,0 +1,223 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "../src/Utils/SyncTable.hpp"
+
+#include <memory>
+
+#include "Utils/Helpers.hpp"
+
+/** Move-only value to check that the table never copies values. */
+using Value_t = std::unique_ptr<size_t>;
+using Table_t = tnt::SyncTable<Value_t, 1024>;
+
+static Value_t
+makeValue(size_t key)
+{
+	return std::make_unique<size_t>(key);
+}
+
+static void
+checkTake(Table_t &table, size_t key)
+{
+	std::optional<Value_t> value = table.take(key);
+	fail_unless(value.has_value());
+	fail_unless(**value == key);
+	fail_unless(table.find(key) == nullptr);
+}
+
+static void
+sequential()
+{
+	TEST_INIT(0);
+	Table_t table;
+	fail_unless(table.size() == 0);
+	fail_unless(table.find(0) == nullptr);
+	fail_unless(!table.take(0).has_value());
+	for (size_t k = 0; k < 3; ++k) {
+		/* Each round the window grows further. */
+		size_t count = Table_t::MIN_WINDOW << k;
+		size_t base = k * 1000;
+		for (size_t i = base; i < base + count; ++i)
+			table.insert(i, makeValue(i));
+		fail_unless(table.size() == count);
+		for (size_t i = base; i < base + count; ++i) {
+			fail_unless(table.find(i) != nullptr);
+			fail_unless(*table.find(i)->get() == i);
+		}
+		fail_unless(table.find(base + count) == nullptr);
+		for (size_t i = base; i < base + count; ++i)
+			checkTake(table, i);
+		fail_unless(table.size() == 0);
+	}
+}
+
+static void
+out_of_order()
+{
+	TEST_INIT(0);
+	Table_t table;
+	TEST_CASE("Duplicate key is ignored");
+	table.insert(10, makeValue(10));
+	table.insert(10, makeValue(11));
+	fail_unless(table.size() == 1);
+	fail_unless(*table.find(10)->get() == 10);
+	TEST_CASE("Reversed insertion");
+	for (size_t i = 9; i > 0; --i)
+		table.insert(i, makeValue(i));
+	fail_unless(table.size() == 10);
+	for (size_t i = 1; i <= 10; ++i)
+		fail_unless(*table.find(i)->get() == i);
+	TEST_CASE("Take from the middle and the head");
+	checkTake(table, 5);
+	checkTake(table, 10);
+	checkTake(table, 1);
+	fail_unless(table.size() == 7);
+	TEST_CASE("Late key behind the head of the window");
+	checkTake(table, 2);
+	checkTake(table, 3);
+	checkTake(table, 4);
+	table.insert(0, makeValue(0));
+	fail_unless(table.size() == 5);
+	for (size_t i : {0, 6, 7, 8, 9})
+		checkTake(table, i);
+	fail_unless(table.size() == 0);
+	TEST_CASE("Window head skips key which has not arrived yet");
+	for (size_t i = 100; i < 108; ++i) {
+		if (i != 103)
+			table.insert(i, makeValue(i));
+	}
+	checkTake(table, 100);
+	checkTake(table, 101);
+	checkTake(table, 102);
+	table.insert(103, makeValue(103));
+	fail_unless(table.size() == 5);
+	for (size_t i = 107; i >= 103; --i)
+		checkTake(table, i);
+	fail_unless(table.size() == 0);
+}
+
+static void
+far_keys()
+{
+	TEST_INIT(0);
+	Table_t table;
+	table.insert(0, makeValue(0));
+	/* Key far ahead of the window goes to the fallback. */
+	table.insert(5000, makeValue(5000));
+	table.insert(1, makeValue(1));
+	fail_unless(table.size() == 3);
+	checkTake(table, 5000);
+	checkTake(table, 0);
+	checkTake(table, 1);
+	fail_unless(table.size() == 0);
+	/* Empty window is moved to any key. */
+	table.insert(1000000, makeValue(1000000));
+	table.insert(1000001, makeValue(1000001));
+	checkTake(table, 1000001);
+	checkTake(table, 1000000);
+	fail_unless(table.size() == 0);
+}
+
+static void
+straggler_key()
+{
+	TEST_INIT(0);
+	Table_t table;
+	table.insert(10, makeValue(10));
+	checkTake(table, 10);
+	table.insert(11, makeValue(11));
+	/* Late key is a straggler. */
+	table.insert(5, makeValue(5));
+	checkTake(table, 11);
+	TEST_CASE("Window moved back does not duplicate straggler key");
+	table.insert(3, makeValue(3));
+	table.insert(5, makeValue(50));
+	fail_unless(table.size() == 2);
+	checkTake(table, 5);
+	fail_unless(!table.take(5).has_value());
+	checkTake(table, 3);
+	fail_unless(table.size() == 0);
+}
+
+/** Counts its live instances. */
+struct Counted {
+	explicit Counted(size_t k) : key(k) { ++alive; }
+	Counted(Counted &&other) : key(other.key) { ++alive; }
+	~Counted() { --alive; }
+	size_t key;
+	static size_t alive;
+};
+
+size_t Counted::alive = 0;
+
+static void
+in_place()
+{
+	TEST_INIT(0);
+	{
+		tnt::SyncTable<Counted, 1024> table;
+		TEST_CASE("Emplaced value does not move while window grows");
+		Counted *first = table.emplace(0, 0);
+		fail_unless(first != nullptr && first->key == 0);
+		fail_unless(table.emplace(0, 1) == nullptr);
+		for (size_t i = 1; i < 100; ++i)
+			fail_unless(table.emplace(i, i) != nullptr);
+		table.emplace(5000, 5000);
+		fail_unless(table.find(0) == first);
+		fail_unless(Counted::alive == 101);
+		TEST_CASE("Each value is visited");
+		size_t visited = 0;
+		table.forEach([&visited](size_t key, Counted &value) {
+			fail_unless(key == value.key);
+			visited++;
+		});
+		fail_unless(visited == 101);
+		TEST_CASE("Erase");
+		fail_unless(table.erase(0));
+		fail_unless(!table.erase(0));
+		fail_unless(table.erase(5000));
+		fail_unless(table.size() == 99);
+		fail_unless(Counted::alive == 99);
+	}
+	TEST_CASE("Values are destroyed with the table");
+	fail_unless(Counted::alive == 0);
+}
+
+int main()
+{
+	sequential();
+	out_of_order();
+	far_keys();
+	straggler_key();
+	in_place();
+	return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include "../src/Utils/TimerWheel.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+#include "Utils/Helpers.hpp"
+
+struct Timer : tnt::WheelTimer<Timer> {
+	uint64_t tick = 0;
+	/* Value of advance() argument the timer is expired by. */
+	uint64_t expired_at = UINT64_MAX;
+};
+
+static void
+simple()
+{
+	TEST_INIT(0);
+	tnt::TimerWheel<Timer> wheel(100);
+	fail_unless(wheel.isEmpty());
+	fail_unless(wheel.nextTick() == UINT64_MAX);
+	Timer a, b, c, d;
+	wheel.add(a, 105);
+	wheel.add(b, 100 + 5000);
+	wheel.add(c, 100 + 1000000);
+	/* Passed tick expires on the next advance. */
+	wheel.add(d, 50);
+	fail_unless(! wheel.isEmpty());
+	fail_unless(wheel.nextTick() == 100);
+	std::vector<Timer *> expired;
+	auto on_expire = [&](Timer &t) { expired.push_back(&t); };
+	fail_unless(wheel.advance(104, on_expire) == 1);
+	fail_unless(expired.size() == 1 && expired[0] == &d);
+	fail_unless(d.isDetached());
+	fail_unless(wheel.nextTick() == 105);
+	fail_unless(wheel.advance(105, on_expire) == 1);
+	fail_unless(expired[1] == &a);
+	TEST_CASE("Removed timer never expires");
+	b.remove();
+	fail_unless(wheel.advance(100 + 10000, on_expire) == 0);
+	TEST_CASE("Timer is unlinked on destruction");
+	{
+		Timer e;
+		wheel.add(e, 100 + 20000);
+	}
+	fail_unless(wheel.advance(100 + 999999, on_expire) == 0);
+	fail_unless(wheel.advance(100 + 1000000, on_expire) == 1);
+	fail_unless(expired[2] == &c);
+	fail_unless(wheel.isEmpty());
+	fail_unless(wheel.now() == 100 + 1000001);
+}
+
+/**
+ * Add random timers and advance the wheel by random steps: each timer
+ * must expire exactly by the first advance() which reaches its tick.
+ */
+template <size_t LEVELS>
+static void
+random_ticks(uint64_t max_delay, uint64_t max_step)
+{
+	TEST_INIT(3, (int) LEVELS, (int) max_delay, (int) max_step);
+	srand(0);
+	constexpr size_t TIMER_COUNT = 10000;
+	std::vector<Timer> timers(TIMER_COUNT);
+	tnt::TimerWheel<Timer, LEVELS> wheel(rand() % 1000);
+	uint64_t prev = wheel.now();
+	size_t added = 0;
+	size_t expired = 0;
+	size_t removed = 0;
+	while (expired + removed < TIMER_COUNT) {
+		for (size_t i = 0; i < 100 && added < TIMER_COUNT; ++i) {
+			Timer &t = timers[added++];
+			t.tick = wheel.now() + rand() % max_delay;
+			wheel.add(t, t.tick);
+		}
+		/* Cancel some random timers. */
+		for (size_t i = 0; i < 10; ++i) {
+			Timer &t = timers[rand() % added];
+			if (t.isDetached())
+				continue;
+			t.remove();
+			t.tick = UINT64_MAX;
+			removed++;
+		}
+		uint64_t next = wheel.nextTick();
+		uint64_t now = prev + 1 + rand() % max_step;
+		expired += wheel.advance(now, [&](Timer &t) {
+			fail_unless(t.tick != UINT64_MAX);
+			fail_unless(t.tick <= now && t.tick > prev);
+			fail_unless(t.tick >= next);
+			t.expired_at = now;
+		});
+		for (size_t i = 0; i < added; ++i) {
+			Timer &t = timers[i];
+			if (t.tick == UINT64_MAX)
+				continue;
+			if (t.tick <= now) {
+				fail_unless(t.expired_at != UINT64_MAX);
+			} else {
+				fail_unless(! t.isDetached());
+			}
+		}
+		prev = now;
+	}
+	fail_unless(wheel.isEmpty());
+}
+
+int main()
+{
+	simple();
+	random_ticks<4>(100, 10);
+	random_ticks<4>(100000, 1000);
+	random_ticks<4>(100000000, 1000000);
+	/* Timers are too far for the wheel: go through the top level. */
+	random_ticks<2>(100000, 100);
+	random_ticks<2>(10000000, 10000);
+	return 0;
+}
@@ -35,8 +35,14 @@
 #include <wait.h>
 #include <sys/prctl.h>
 
+#include <string>
+
+/**
+ * Launch Tarantool listening @a port. Instances on ports other than the
+ * default one keep their files in separate directories (see cfg.lua).
+ */
 int
-launchTarantool()
+launchTarantool(int port = 3301)
 {
 	pid_t ppid_before_fork = getpid();
 	pid_t pid = fork();
@@ -58,6 +64,11 @@ launchTarantool()
 				"just before prctl call");
 		exit(EXIT_FAILURE);
 	}
+	if (setenv("TNTCXX_TEST_PORT", std::to_string(port).c_str(), 1) != 0) {
+		fprintf(stderr, "Can't launch Tarantool: setenv failed! %s\n",
+			strerror(errno));
+		exit(EXIT_FAILURE);
+	}
 	if (execlp("tarantool", "tarantool", "test_cfg.lua", NULL) == -1) {
 		fprintf(stderr, "Can't launch Tarantool: execlp failed! %s\n",
 			strerror(errno));
@@ -81,7 +92,7 @@ cleanDir() {
 		fprintf(stderr, "wait: child finished with error \n");
 		return -1;
 	}
-	if (execlp("/bin/sh", "/bin/sh", "-c", "rm *xlog *snap", NULL) == -1) {
+	if (execlp("/bin/sh", "/bin/sh", "-c", "rm -rf *xlog *snap instance_*", NULL) == -1) {
 		fprintf(stderr, "Failed to clean directory: execlp failed! %s\n",
 			strerror(errno));
 	}
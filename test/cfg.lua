@@ -1,5 +1,15 @@
-box.cfg{listen = 3301, net_msg_max=10000, readahead=163200, log_level = 7, log='tarantool.txt'}
+-- Several instances (e.g. shards) may be launched on different ports.
+local port = tonumber(os.getenv('TNTCXX_TEST_PORT')) or 3301
+local dir = '.'
+if port ~= 3301 then
+    dir = 'instance_' .. port
+    os.execute('mkdir -p ' .. dir)
+end
+box.cfg{listen = port, memtx_dir = dir, wal_dir = dir, net_msg_max=10000, readahead=163200, log_level = 7, log = dir .. '/tarantool.txt',
+         memtx_use_mvcc_engine = true}
 box.schema.user.grant('guest', 'super', nil, nil, {if_not_exists=true})
+box.schema.user.create('test', {password = 'test', if_not_exists = true})
+box.schema.user.grant('test', 'super', nil, nil, {if_not_exists=true})
 
 if box.space.t then box.space.t:drop() end
 s = box.schema.space.create('T')